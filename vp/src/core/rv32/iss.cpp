@@ -60,14 +60,15 @@ using namespace rv32;
 #define PC solver.BVC(std::nullopt, (uint32_t)pc)
 #define LAST_PC solver.BVC(std::nullopt, (uint32_t)last_pc)
 
-#define I_IMM solver.BVC(std::nullopt, (uint32_t)instr.I_imm())->sext(32)
-#define S_IMM solver.BVC(std::nullopt, (uint32_t)instr.S_imm())->sext(32)
-#define U_IMM solver.BVC(std::nullopt, (uint32_t)instr.U_imm()) /* XXX: sext? */
-#define SHAMT solver.BVC(std::nullopt, (uint32_t)instr.shamt())
+// immediates are folded at decode time, see ISS::fold_immediate
+#define I_IMM imm
+#define S_IMM imm
+#define U_IMM imm /* XXX: sext? */
+#define SHAMT imm
 
-#define REG_UINT32_MAX solver.BVC(std::nullopt, (uint32_t)-1)
-#define REG_INT32_MIN solver.BVC(std::nullopt, (uint32_t)REG_MIN)
-#define REG_ZERO solver.BVC(std::nullopt, (uint32_t)0)
+#define REG_UINT32_MAX constant((uint32_t)-1)
+#define REG_INT32_MIN int32_min_value
+#define REG_ZERO regs.zero_value
 
 const char *regnames[] = {
     "zero (x0)", "ra   (x1)", "sp   (x2)", "gp   (x3)", "tp   (x4)", "t0   (x5)", "t1   (x6)", "t2   (x7)",
@@ -89,13 +90,20 @@ int regcolors[] = {
 };
 
 RegFile::RegFile(clover::Solver &_solver, clover::Trace &_trace) : solver(_solver), trace(_trace) {
+	zero_value = solver.BVC(std::nullopt, (uint32_t)0);
 	for (size_t i = 0; i < regs.size(); i++)
-		regs[i] = solver.BVC(std::nullopt, (uint32_t)0);
+		regs[i] = zero_value;
+	values.fill(0);
 }
 
 RegFile::RegFile(clover::Solver &_solver, clover::Trace &_trace, const RegFile &other) : solver(_solver), trace(_trace) {
+	zero_value = other.zero_value;
 	for (size_t i = 0; i < regs.size(); i++)
 		regs[i] = other.regs[i];
+
+	values = other.values;
+	tainted = other.tainted;
+	stale = other.stale;
 }
 
 void RegFile::write(uint32_t index, RegFile::RegValue value) {
@@ -106,21 +114,60 @@ void RegFile::write(uint32_t index, RegFile::RegValue value) {
 		regs[index] = value;
 	else
 		assert("invalid register width");
+
+	values[index] = solver.getValue<uint32_t>(regs[index]->concrete);
+	if (regs[index]->symbolic.has_value())
+		tainted |= (1u << index);
+	else
+		tainted &= ~(1u << index);
+	stale &= ~(1u << index);
 }
 
 RegFile::RegValue RegFile::read(uint32_t index) {
 	if (index > x31)
 		throw std::out_of_range("out-of-range register access");
-	return regs[index];
+	return (*this)[index];
 }
 
 RegFile::RegValue RegFile::shamt(uint32_t index) {
 	assert(index <= x31);
-	return regs[index]->extract(0, 5)->zext(32);
+	return (*this)[index]->extract(0, 5)->zext(32);
 }
 
-const RegFile::RegValue &RegFile::operator[](const uint32_t idx) {
-	return regs[idx];
+DecodeCache::Entry &DecodeCache::lookup(uint32_t addr) {
+	uint32_t num = addr >> PAGE_BITS;
+	if (!last_page || last_page_num != num) {
+		auto &page = pages[num];
+		if (!page)
+			page = std::make_unique<Page>();
+
+		last_page_num = num;
+		last_page = page.get();
+	}
+
+	return (*last_page)[(addr & (PAGE_SIZE - 1)) / 2];
+}
+
+void DecodeCache::invalidate(uint32_t addr, size_t len) {
+	if (pages.empty())
+		return;
+
+	// A 32 bit instruction starting in the preceding halfword overlaps,
+	// unless the store is at the very beginning of the address space.
+	uint32_t start = (addr >= 2) ? (addr & ~1) - 2 : 0;
+	uint64_t count = ((uint64_t)addr + len - start + 1) / 2;
+
+	for (uint64_t i = 0; i < count; i++) {
+		uint32_t a = start + i * 2;
+		auto it = pages.find(a >> PAGE_BITS);
+		if (it != pages.end())
+			(*it->second)[(a & (PAGE_SIZE - 1)) / 2].size = 0;
+	}
+}
+
+void DecodeCache::flush() {
+	pages.clear();
+	last_page = nullptr;
 }
 
 #if defined(COLOR_THEME_LIGHT) || defined(COLOR_THEME_DARK)
@@ -134,19 +181,20 @@ const RegFile::RegValue &RegFile::operator[](const uint32_t idx) {
 void RegFile::show() {
 	for (size_t i = 0; i < regs.size(); i++) {
 		std::string bvs = "none";
-		if (regs[i]->symbolic.has_value()) {
-			auto q = trace.getQuery(*regs[i]->symbolic);
+		auto reg = (*this)[i];
+		if (reg->symbolic.has_value()) {
+			auto q = trace.getQuery(*reg->symbolic);
 			auto v = solver.evalValue<uint32_t>(q);
 			bvs = std::to_string(v);
 		}
 
-		uint32_t bvv = solver.getValue<uint32_t>(regs[i]->concrete);
+		uint32_t bvv = values[i];
 		printf("%s = (%s, %" PRIx32 ")\n", regnames[i], bvs.c_str(), bvv);
 	}
 }
 
 ISS::ISS(SymbolicContext &c, uint32_t hart_id, bool use_E_base_isa)
-  : solver(c.solver), ctx(c.ctx), tracer(c.trace), regs(solver, tracer), systemc_name("Core-" + std::to_string(hart_id)) {
+  : solver(c.solver), ctx(c.ctx), tracer(c.trace), coverage(c.coverage), limits(c.limits), concrete_evals(c.concrete_evals), regs(solver, tracer), systemc_name("Core-" + std::to_string(hart_id)) {
 	csrs.mhartid.reg = hart_id;
 	if (use_E_base_isa)
 		csrs.misa.select_E_base_isa();
@@ -178,31 +226,297 @@ ISS::ISS(SymbolicContext &c, uint32_t hart_id, bool use_E_base_isa)
 	instr_cycles[Opcode::DIVU] = mul_div_cycles;
 	instr_cycles[Opcode::REM] = mul_div_cycles;
 	instr_cycles[Opcode::REMU] = mul_div_cycles;
+
+	int32_min_value = solver.BVC(std::nullopt, (uint32_t)REG_MIN);
+
+	// Control transfers and instructions which may change the
+	// privilege level, interrupt state or bus lock end a block.
+	block_end.fill(false);
+	for (auto end : {Opcode::UNDEF, Opcode::JAL, Opcode::JALR, Opcode::BEQ, Opcode::BNE, Opcode::BLT, Opcode::BGE,
+	                 Opcode::BLTU, Opcode::BGEU, Opcode::FENCE, Opcode::ECALL, Opcode::EBREAK, Opcode::FENCE_I,
+	                 Opcode::CSRRW, Opcode::CSRRS, Opcode::CSRRC, Opcode::CSRRWI, Opcode::CSRRSI, Opcode::CSRRCI,
+	                 Opcode::URET, Opcode::SRET, Opcode::MRET, Opcode::WFI, Opcode::SFENCE_VMA})
+		block_end[end] = true;
+	for (int i = Opcode::LR_W; i <= Opcode::AMOMAXU_W; ++i)
+		block_end[i] = true;
+
 	op = Opcode::UNDEF;
 }
 
+RegFile::RegValue ISS::constant(uint32_t value) {
+	int32_t v = value;
+	if (v < SMALL_CONSTANT_MIN || v > SMALL_CONSTANT_MAX)
+		return solver.BVC(clover::ConcreteValue(value, 32));
+
+	auto &c = small_constants[v - SMALL_CONSTANT_MIN];
+	if (!c)
+		c = solver.BVC(clover::ConcreteValue(value, 32));
+	return c;
+}
+
+/* Returns the immediate operand of the current instruction as a 32 bit
+ * concolic value (sign-extended where applicable), nullptr if it has
+ * none. Used by the I_IMM, S_IMM, U_IMM and SHAMT macros. */
+RegFile::RegValue ISS::fold_immediate() {
+	switch (op) {
+		case Opcode::SLLI:
+		case Opcode::SRLI:
+		case Opcode::SRAI:
+			return constant(instr.shamt());
+		default:
+			break;
+	}
+
+	switch (Opcode::getType(op)) {
+		case Opcode::Type::I:
+			return constant(instr.I_imm());
+		case Opcode::Type::S:
+			return constant(instr.S_imm());
+		case Opcode::Type::U:
+			return constant(instr.U_imm());
+		default:
+			return nullptr;
+	}
+}
+
+static inline uint32_t shift_left(uint32_t value, uint32_t shamt) {
+	return (shamt >= 32) ? 0 : value << shamt;
+}
+
+static inline uint32_t shift_right(uint32_t value, uint32_t shamt) {
+	return (shamt >= 32) ? 0 : value >> shamt;
+}
+
+static inline uint32_t shift_right_arith(uint32_t value, uint32_t shamt) {
+	return (uint32_t)((int32_t)value >> ((shamt >= 32) ? 31 : shamt));
+}
+
+/* Executes the current instruction natively on the concrete register values
+ * if none of its register operands is tainted, i.e. holds a symbolic value.
+ * This covers the integer instructions dominating the execution of concrete
+ * code, the results are equivalent to those of the concolic implementation
+ * in exec_step(). Returns false if the instruction must be executed
+ * concolically instead. */
+bool ISS::exec_concrete() {
+	auto branch = [this](bool cond) {
+		concrete_evals.add();
+		if (cond) {
+			pc = last_pc + instr.B_imm();
+			trap_check_pc_alignment();
+		}
+		coverage.branch(last_pc, cond);
+		return true;
+	};
+
+	// Instructions without register operands
+	switch (op) {
+		case Opcode::LUI:
+			regs.write_concrete(RD, instr.U_imm());
+			return true;
+
+		case Opcode::AUIPC:
+			regs.write_concrete(RD, last_pc + instr.U_imm());
+			return true;
+
+		case Opcode::JAL: {
+			uint32_t link = pc;
+			pc = last_pc + instr.J_imm();
+			trap_check_pc_alignment();
+			regs.write_concrete(RD, link);
+		} return true;
+
+		default:
+			break;
+	}
+
+	if (!regs.is_concrete(RS1))
+		return false;
+	uint32_t a = regs.concrete(RS1);
+
+	// Instructions with a single register operand
+	switch (op) {
+		case Opcode::ADDI:
+			regs.write_concrete(RD, a + instr.I_imm());
+			return true;
+
+		case Opcode::SLTI:
+			regs.write_concrete(RD, (int32_t)a < instr.I_imm());
+			return true;
+
+		case Opcode::SLTIU:
+			regs.write_concrete(RD, a < (uint32_t)instr.I_imm());
+			return true;
+
+		case Opcode::XORI:
+			regs.write_concrete(RD, a ^ instr.I_imm());
+			return true;
+
+		case Opcode::ORI:
+			regs.write_concrete(RD, a | instr.I_imm());
+			return true;
+
+		case Opcode::ANDI:
+			regs.write_concrete(RD, a & instr.I_imm());
+			return true;
+
+		case Opcode::SLLI:
+			regs.write_concrete(RD, shift_left(a, instr.shamt()));
+			return true;
+
+		case Opcode::SRLI:
+			regs.write_concrete(RD, shift_right(a, instr.shamt()));
+			return true;
+
+		case Opcode::SRAI:
+			regs.write_concrete(RD, shift_right_arith(a, instr.shamt()));
+			return true;
+
+		case Opcode::JALR: {
+			uint32_t link = pc;
+			pc = (a + instr.I_imm()) & ~1;
+			trap_check_pc_alignment();
+			regs.write_concrete(RD, link);
+		} return true;
+
+		default:
+			break;
+	}
+
+	if (!regs.is_concrete(RS2))
+		return false;
+	uint32_t b = regs.concrete(RS2);
+
+	// Instructions with two register operands
+	switch (op) {
+		case Opcode::ADD:
+			regs.write_concrete(RD, a + b);
+			return true;
+
+		case Opcode::SUB:
+			regs.write_concrete(RD, a - b);
+			return true;
+
+		case Opcode::SLL:
+			regs.write_concrete(RD, shift_left(a, b & 0x1f));
+			return true;
+
+		case Opcode::SLT:
+			regs.write_concrete(RD, (int32_t)a < (int32_t)b);
+			return true;
+
+		case Opcode::SLTU:
+			regs.write_concrete(RD, a < b);
+			return true;
+
+		case Opcode::SRL:
+			regs.write_concrete(RD, shift_right(a, b & 0x1f));
+			return true;
+
+		case Opcode::SRA:
+			regs.write_concrete(RD, shift_right_arith(a, b & 0x1f));
+			return true;
+
+		case Opcode::XOR:
+			regs.write_concrete(RD, a ^ b);
+			return true;
+
+		case Opcode::OR:
+			regs.write_concrete(RD, a | b);
+			return true;
+
+		case Opcode::AND:
+			regs.write_concrete(RD, a & b);
+			return true;
+
+		case Opcode::MUL:
+			REQUIRE_ISA(M_ISA_EXT);
+			regs.write_concrete(RD, a * b);
+			return true;
+
+		case Opcode::MULH:
+			REQUIRE_ISA(M_ISA_EXT);
+			regs.write_concrete(RD, (uint64_t)((int64_t)(int32_t)a * (int64_t)(int32_t)b) >> 32);
+			return true;
+
+		case Opcode::MULHU:
+			REQUIRE_ISA(M_ISA_EXT);
+			regs.write_concrete(RD, ((uint64_t)a * (uint64_t)b) >> 32);
+			return true;
+
+		case Opcode::MULHSU:
+			REQUIRE_ISA(M_ISA_EXT);
+			regs.write_concrete(RD, ((uint64_t)(int64_t)(int32_t)a * (uint64_t)b) >> 32);
+			return true;
+
+		case Opcode::BEQ:
+			return branch(a == b);
+
+		case Opcode::BNE:
+			return branch(a != b);
+
+		case Opcode::BLT:
+			return branch((int32_t)a < (int32_t)b);
+
+		case Opcode::BGE:
+			return branch((int32_t)a >= (int32_t)b);
+
+		case Opcode::BLTU:
+			return branch(a < b);
+
+		case Opcode::BGEU:
+			return branch(a >= b);
+
+		default:
+			return false;
+	}
+}
+
 void ISS::exec_step() {
 	assert(((pc & ~pc_alignment_mask()) == 0) && "misaligned instruction");
+	coverage.visit(pc);
+
+	// Instruction addresses are physical unless translated by the MMU.
+	DecodeCache::Entry *entry = nullptr;
+	if (csrs.satp.mode == SATP_MODE_BARE || prv == MachineMode)
+		entry = &decode_cache.lookup(pc);
+
+	uint8_t size;
+	if (entry && entry->size) {
+		instr = entry->instr;
+		op = entry->op;
+		size = entry->size;
+		imm = entry->imm;
+	} else {
+		try {
+			uint32_t mem_word = instr_mem->load_instr(pc);
+			instr = Instruction(mem_word);
+		} catch (SimulationTrap &e) {
+			op = Opcode::UNDEF;
+			instr = Instruction(0);
+			throw;
+		}
 
-	try {
-		uint32_t mem_word = instr_mem->load_instr(pc);
-		instr = Instruction(mem_word);
-	} catch (SimulationTrap &e) {
-		op = Opcode::UNDEF;
-		instr = Instruction(0);
-		throw;
-	}
+		if (instr.is_compressed()) {
+			op = instr.decode_and_expand_compressed(RV32);
+			size = 2;
+		} else {
+			op = instr.decode_normal(RV32);
+			size = 4;
+		}
 
-	if (instr.is_compressed()) {
-		op = instr.decode_and_expand_compressed(RV32);
-		pc += 2;
-        if (op != Opcode::UNDEF)
-            REQUIRE_ISA(C_ISA_EXT);
-    } else {
-		op = instr.decode_normal(RV32);
-		pc += 4;
+		imm = fold_immediate();
+		if (entry) {
+			entry->instr = instr;
+			entry->op = op;
+			entry->size = size;
+			entry->imm = imm;
+		}
 	}
 
+	pc += size;
+	if (size == 2 && op != Opcode::UNDEF)
+		REQUIRE_ISA(C_ISA_EXT);
+
 	if (trace) {
 		printf("core %2u: prv %1x: pc %8x: %s ", csrs.mhartid.reg, prv, last_pc, Opcode::mappingStr[op]);
 		switch (Opcode::getType(op)) {
@@ -234,6 +548,9 @@ void ISS::exec_step() {
 		puts("");
 	}
 
+	if (exec_concrete())
+		return;
+
 	switch (op) {
 		case Opcode::UNDEF:
 			if (trace)
@@ -396,6 +713,7 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
@@ -407,6 +725,7 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
@@ -418,6 +737,7 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
@@ -429,6 +749,7 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
@@ -440,6 +761,7 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
@@ -451,14 +773,18 @@ void ISS::exec_step() {
 				trap_check_pc_alignment();
 			}
 
+			coverage.branch(last_pc, cond);
 			track_and_trace_branch(cond, res);
 		} break;
 
-		case Opcode::FENCE:
-		case Opcode::FENCE_I: {
+		case Opcode::FENCE: {
 			// not using out of order execution so can be ignored
 		} break;
 
+		case Opcode::FENCE_I: {
+			decode_cache.flush();
+		} break;
+
 		case Opcode::ECALL: {
 			if (sys) {
 				sys->execute_syscall(this);
@@ -1489,36 +1815,46 @@ void ISS::set_csr_value(uint32_t addr, uint32_t value) {
 
 		case MSTATUS_ADDR:
 			write(csrs.mstatus, MSTATUS_MASK);
+			interrupts_changed = true;
 			break;
 		case SSTATUS_ADDR:
 			write(csrs.mstatus, SSTATUS_MASK);
+			interrupts_changed = true;
 			break;
 		case USTATUS_ADDR:
 			write(csrs.mstatus, USTATUS_MASK);
+			interrupts_changed = true;
 			break;
 
 		case MIP_ADDR:
 			write(csrs.mip, MIP_WRITE_MASK);
+			interrupts_changed = true;
 			break;
 		case SIP_ADDR:
 			write(csrs.mip, SIP_MASK);
+			interrupts_changed = true;
 			break;
 		case UIP_ADDR:
 			write(csrs.mip, UIP_MASK);
+			interrupts_changed = true;
 			break;
 
 		case MIE_ADDR:
 			write(csrs.mie, MIE_MASK);
+			interrupts_changed = true;
 			break;
 		case SIE_ADDR:
 			write(csrs.mie, SIE_MASK);
+			interrupts_changed = true;
 			break;
 		case UIE_ADDR:
 			write(csrs.mie, UIE_MASK);
+			interrupts_changed = true;
 			break;
 
 		case MIDELEG_ADDR:
 			write(csrs.mideleg, MIDELEG_MASK);
+			interrupts_changed = true;
 			break;
 
 		case MEDELEG_ADDR:
@@ -1527,6 +1863,7 @@ void ISS::set_csr_value(uint32_t addr, uint32_t value) {
 
 		case SIDELEG_ADDR:
 			write(csrs.sideleg, SIDELEG_MASK);
+			interrupts_changed = true;
 			break;
 
 		case SEDELEG_ADDR:
@@ -1643,10 +1980,8 @@ uint64_t ISS::get_hart_id() {
 std::vector<uint64_t> ISS::get_registers(void) {
     std::vector<uint64_t> regvals;
 
-    for (auto v : regs.regs) {
-        auto regval = solver.getValue<uint32_t>(v->concrete);
+    for (auto regval : regs.values)
         regvals.push_back(regval);
-    }
 
     return regvals;
 }
@@ -1690,6 +2025,8 @@ void ISS::fp_require_not_off() {
 }
 
 void ISS::return_from_trap_handler(PrivilegeLevel return_mode) {
+	interrupts_changed = true;
+
 	switch (return_mode) {
 		case MachineMode:
 			prv = csrs.mstatus.mpp;
@@ -1730,6 +2067,7 @@ void ISS::return_from_trap_handler(PrivilegeLevel return_mode) {
 }
 
 void ISS::trigger_external_interrupt(PrivilegeLevel level) {
+	interrupts_changed = true;
 	if (trace)
 		std::cout << "[vp::iss] trigger external interrupt, " << sc_core::sc_time_stamp() << std::endl;
 
@@ -1749,6 +2087,7 @@ void ISS::trigger_external_interrupt(PrivilegeLevel level) {
 }
 
 void ISS::clear_external_interrupt(PrivilegeLevel level) {
+	interrupts_changed = true;
 	if (trace)
 		std::cout << "[vp::iss] clear external interrupt, " << sc_core::sc_time_stamp() << std::endl;
 
@@ -1766,6 +2105,7 @@ void ISS::clear_external_interrupt(PrivilegeLevel level) {
 }
 
 void ISS::trigger_timer_interrupt(bool status) {
+	interrupts_changed = true;
 	if (trace)
 		std::cout << "[vp::iss] trigger timer interrupt=" << status << ", " << sc_core::sc_time_stamp() << std::endl;
 	csrs.mip.mtip = status;
@@ -1773,6 +2113,7 @@ void ISS::trigger_timer_interrupt(bool status) {
 }
 
 void ISS::trigger_software_interrupt(bool status) {
+	interrupts_changed = true;
 	if (trace)
 		std::cout << "[vp::iss] trigger software interrupt=" << status << ", " << sc_core::sc_time_stamp() << std::endl;
 	csrs.mip.msip = status;
@@ -1893,6 +2234,7 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 
 	// free any potential LR/SC bus lock before processing a trap/interrupt
 	release_lr_sc_reservation();
+	interrupts_changed = true;
 
 	auto pp = prv;
 	prv = target_mode;
@@ -1945,8 +2287,9 @@ void ISS::switch_to_trap_handler(PrivilegeLevel target_mode) {
 	}
 }
 
-void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
+void ISS::performance_update(Opcode::Mapping executed_op) {
     ++total_num_instr;
+	limits.check_instructions(total_num_instr);
 
 	if (!csrs.mcountinhibit.IR)
 		++csrs.instret.reg;
@@ -1964,42 +2307,57 @@ void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
 		cycle_counter += new_cycles;
 
 	quantum_keeper.inc(new_cycles);
+}
+
+void ISS::sync_update() {
 	if (quantum_keeper.need_sync()) {
+		limits.check(quantum_keeper.get_current_time().to_seconds());
 	    if (lr_sc_counter == 0) // match SystemC sync with bus unlocking in a tight LR_W/SC_W loop
 		    quantum_keeper.sync();
 	}
 }
 
-void ISS::run_step() {
+/* Executes instructions until the end of the current basic block, i.e.
+ * until a control transfer or an instruction which may affect interrupts
+ * (see block_end), or a single instruction only. Instructions are taken
+ * from the decode cache, pending interrupts and the quantum are only
+ * checked at the end of the block. Pending interrupts are re-evaluated
+ * only if their inputs changed (see interrupts_changed). Interrupts
+ * triggered by other modules during the block (e.g. through a store)
+ * also end the block. */
+void ISS::run_block(bool single_step) {
 	assert(solver.getValue<uint32_t>(regs.read(0)->concrete) == 0);
 
-	// speeds up the execution performance (non debug mode) significantly by
-	// checking the additional flag first
-	if (debug_mode && (breakpoints.find(pc) != breakpoints.end())) {
-		status = CoreExecStatus::HitBreakpoint;
-		return;
-	}
-
-	last_pc = pc;
-	try {
-		exec_step();
-
-		auto x = compute_pending_interrupts();
-		if (x.target_mode != NoneMode) {
-			prepare_interrupt(x);
-			switch_to_trap_handler(x.target_mode);
+	bool end = false;
+	do {
+		last_pc = pc;
+		try {
+			exec_step();
+
+			end = single_step || block_end[op] || interrupts_changed || shall_exit;
+			if (interrupts_changed) {
+				interrupts_changed = false;
+				auto x = compute_pending_interrupts();
+				if (x.target_mode != NoneMode) {
+					prepare_interrupt(x);
+					switch_to_trap_handler(x.target_mode);
+				}
+			}
+		} catch (SimulationTrap &e) {
+			if (trace)
+				std::cout << "take trap " << e.reason << ", mtval=" << e.mtval << std::endl;
+			auto target_mode = prepare_trap(e);
+			switch_to_trap_handler(target_mode);
+			end = true;
 		}
-	} catch (SimulationTrap &e) {
-		if (trace)
-			std::cout << "take trap " << e.reason << ", mtval=" << e.mtval << std::endl;
-		auto target_mode = prepare_trap(e);
-		switch_to_trap_handler(target_mode);
-	}
 
-	// NOTE: writes to zero register are supposedly allowed but must be ignored
-	// (reset it after every instruction, instead of checking *rd != zero*
-	// before every register write)
-	regs.write(regs.zero, solver.BVC(std::nullopt, (uint32_t)0));
+		// NOTE: writes to zero register are supposedly allowed but must be ignored
+		// (reset it after every instruction, instead of checking *rd != zero*
+		// before every register write)
+		regs.reset_zero();
+
+		performance_update(op);
+	} while (!end);
 
 	// Do not use a check *pc == last_pc* here. The reason is that due to
 	// interrupts *pc* can be set to *last_pc* accidentally (when jumping back
@@ -2007,14 +2365,28 @@ void ISS::run_step() {
 	if (shall_exit)
 		status = CoreExecStatus::Terminated;
 
-	performance_and_sync_update(op);
+	sync_update();
+}
+
+void ISS::run_step() {
+	// speeds up the execution performance (non debug mode) significantly by
+	// checking the additional flag first
+	if (debug_mode && (breakpoints.find(pc) != breakpoints.end())) {
+		status = CoreExecStatus::HitBreakpoint;
+		return;
+	}
+
+	run_block(true);
 }
 
 void ISS::run() {
-	// run a single step until either a breakpoint is hit or the execution
-	// terminates
+	// run until either a breakpoint is hit or the execution terminates,
+	// breakpoints require checking each instruction individually
 	do {
-		run_step();
+		if (debug_mode)
+			run_step();
+		else
+			run_block(false);
 	} while (status == CoreExecStatus::Runnable);
 
 	// force sync to make sure that no action is missed
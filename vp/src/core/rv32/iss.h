@@ -57,11 +57,13 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <array>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -77,8 +79,21 @@ struct RegFile {
 	clover::Trace &trace;
 	static constexpr unsigned NUM_REGS = 32;
 
-	typedef std::shared_ptr<clover::ConcolicValue> RegValue;
+	typedef clover::Ref<clover::ConcolicValue> RegValue;
+
+	// Concolic register values. Values of registers written through
+	// write_concrete() are only created on access, use read() or
+	// operator[] instead of accessing this array directly.
 	std::array<RegValue, NUM_REGS> regs;
+	RegValue zero_value;
+
+	// Taint summary of the register file, one bit per register for
+	// registers holding a symbolic value (tainted) and registers whose
+	// concolic value has not been created yet (stale). The concrete
+	// values of all registers are always available natively.
+	std::array<uint32_t, NUM_REGS> values;
+	uint32_t tainted = 0;
+	uint32_t stale = 0;
 
 	RegFile(clover::Solver &_solver, clover::Trace &_trace);
 
@@ -90,7 +105,36 @@ struct RegFile {
 
 	RegFile::RegValue shamt(uint32_t index);
 
-	const RegValue &operator[](const uint32_t idx);
+	inline const RegValue &operator[](const uint32_t idx) {
+		if (stale & (1u << idx)) {
+			regs[idx] = solver.BVC(clover::ConcreteValue(values[idx], 32));
+			stale &= ~(1u << idx);
+		}
+		return regs[idx];
+	}
+
+	inline bool is_concrete(uint32_t index) {
+		return !(tainted & (1u << index));
+	}
+
+	inline uint32_t concrete(uint32_t index) {
+		return values[index];
+	}
+
+	inline void write_concrete(uint32_t index, uint32_t value) {
+		values[index] = value;
+		tainted &= ~(1u << index);
+		stale |= (1u << index);
+	}
+
+	// Writes to the zero register must be ignored, undo them.
+	inline void reset_zero() {
+		values[x0] = 0;
+		tainted &= ~1u;
+		stale &= ~1u;
+		if (regs[x0] != zero_value)
+			regs[x0] = zero_value;
+	}
 
 	void show();
 
@@ -192,6 +236,34 @@ struct InstructionBuffer {
 	}
 };
 
+/* Cache of decoded instructions, organized in pages of instruction memory
+ * with one entry per halfword. Avoids fetching and decoding instructions
+ * on each execution. Entries are keyed by physical address and must be
+ * invalidated on stores to the corresponding memory, see invalidate(). */
+struct DecodeCache {
+	static constexpr unsigned PAGE_BITS = 12;
+	static constexpr uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+
+	struct Entry {
+		Instruction instr;  // expanded, if compressed
+		Opcode::Mapping op = Opcode::UNDEF;
+		uint8_t size = 0;  // zero if not decoded yet
+
+		// Immediate operand, see ISS::fold_immediate().
+		clover::Ref<clover::ConcolicValue> imm;
+	};
+
+	typedef std::array<Entry, PAGE_SIZE / 2> Page;
+
+	std::unordered_map<uint32_t, std::unique_ptr<Page>> pages;
+	uint32_t last_page_num = 0;
+	Page *last_page = nullptr;
+
+	Entry &lookup(uint32_t addr);
+	void invalidate(uint32_t addr, size_t len);
+	void flush();
+};
+
 struct PendingInterrupts {
 	PrivilegeLevel target_mode;
 	uint32_t pending;
@@ -201,6 +273,9 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	clover::Solver &solver;
 	clover::ExecutionContext &ctx;
 	clover::Trace &tracer;
+	Coverage &coverage;
+	PathLimits &limits;
+	ConcreteEvals &concrete_evals;
 
 	clint_if *clint = nullptr;
 	instr_memory_if *instr_mem = nullptr;
@@ -221,6 +296,18 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	// last decoded and executed instruction and opcode
 	Instruction instr;
 	Opcode::Mapping op;
+	DecodeCache decode_cache;
+
+	// immediate operand of the last decoded instruction
+	RegFile::RegValue imm;
+
+	// Shared concolic values of constants in the range of 12 bit signed
+	// immediates, created on first use. Values are immutable, sharing
+	// them avoids allocating new values for each executed instruction.
+	static constexpr int32_t SMALL_CONSTANT_MIN = -2048;
+	static constexpr int32_t SMALL_CONSTANT_MAX = 2047;
+	std::array<RegFile::RegValue, SMALL_CONSTANT_MAX - SMALL_CONSTANT_MIN + 1> small_constants;
+	RegFile::RegValue int32_min_value;
 
 	CoreExecStatus status = CoreExecStatus::Runnable;
 	std::unordered_set<uint32_t> breakpoints;
@@ -234,6 +321,16 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	sc_core::sc_time cycle_counter;  // use a separate cycle counter, since cycle count can be inhibited
 	std::array<sc_core::sc_time, Opcode::NUMBER_OF_INSTRUCTIONS> instr_cycles;
 
+	// Instructions terminating a basic block, see run_block().
+	std::array<bool, Opcode::NUMBER_OF_INSTRUCTIONS> block_end;
+
+	// Set if the inputs of compute_pending_interrupts() may have changed,
+	// i.e. pending or enabled interrupts, delegation or the privilege
+	// level. Pending interrupts are only re-evaluated in this case. Since
+	// other modules may trigger interrupts during the execution of an
+	// instruction (e.g. a store to the CLINT), this also ends a block.
+	bool interrupts_changed = true;
+
 	static constexpr int32_t REG_MIN = INT32_MIN;
     static constexpr unsigned xlen = 32;
 
@@ -241,6 +338,12 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void exec_step();
 
+	bool exec_concrete();
+
+	RegFile::RegValue constant(uint32_t value);
+
+	RegFile::RegValue fold_immediate();
+
 	uint64_t _compute_and_get_current_cycles();
 
 	void init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint32_t entrypoint, uint32_t sp);
@@ -261,12 +364,24 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
     std::vector<uint64_t> get_registers(void) override;
 
-    bool eval(std::shared_ptr<clover::BitVector> bv) {
+    bool eval(clover::Ref<clover::BitVector> bv) {
+        // Constant conditions don't depend on the path constraints,
+        // neither simplification nor the solver is needed for them.
+        if (auto ce = dyn_cast<klee::ConstantExpr>(bv->expr)) {
+            concrete_evals.add();
+            return ce->isTrue();
+        }
+
         auto q = tracer.getQuery(bv);
         return solver.eval(q);
     };
 
-    void track_and_trace_branch(bool cond, std::shared_ptr<clover::ConcolicValue> expr) {
+    bool eval(const clover::ConcreteValue &value) {
+        concrete_evals.add();
+        return value.getZExtValue(klee::Expr::Bool);
+    };
+
+    void track_and_trace_branch(bool cond, clover::Ref<clover::ConcolicValue> expr) {
         if (expr->symbolic.has_value())
             tracer.add(cond, *expr->symbolic, last_pc);
     };
@@ -333,7 +448,7 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	}
 
 	template <unsigned Alignment, bool isLoad>
-	inline void trap_check_addr_alignment(std::shared_ptr<clover::ConcolicValue> addr) {
+	inline void trap_check_addr_alignment(clover::Ref<clover::ConcolicValue> addr) {
 		auto caddr = solver.getValue<uint32_t>(addr->concrete);
 		if (unlikely(caddr % Alignment)) {
 			raise_trap(isLoad ? EXC_LOAD_ADDR_MISALIGNED : EXC_STORE_AMO_ADDR_MISALIGNED, caddr);
@@ -374,7 +489,11 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void switch_to_trap_handler(PrivilegeLevel target_mode);
 
-	void performance_and_sync_update(Opcode::Mapping executed_op);
+	void performance_update(Opcode::Mapping executed_op);
+
+	void sync_update();
+
+	void run_block(bool single_step);
 
 	void run_step() override;
 
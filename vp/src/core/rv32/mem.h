@@ -78,10 +78,55 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 	sc_core::sc_time dmi_access_delay = clock_cycle * 4;
 	std::vector<MemoryDMI> dmi_ranges;
 
+	// Request DMI ranges from targets which allow it (e.g. pages of
+	// SymbolicMemory without symbolic bytes) for instruction fetches
+	// and data accesses respectively. Granted ranges are added to
+	// dmi_ranges and removed again once invalidated by the target.
+	bool instr_dmi = false;
+	bool data_dmi = false;
+
     MMU *mmu;
 
 	CombinedMemoryInterface(sc_core::sc_module_name, ISS &owner, MMU *mmu = nullptr)
 	    : iss(owner), quantum_keeper(iss.quantum_keeper), mmu(mmu) {
+		isock.register_invalidate_direct_mem_ptr(this, &CombinedMemoryInterface::invalidate_direct_mem_ptr);
+	}
+
+	MemoryDMI *find_dmi(uint64_t addr, size_t num_bytes) {
+		for (size_t i = 0; i < dmi_ranges.size(); i++) {
+			auto &e = dmi_ranges[i];
+			if (!e.contains(addr) || addr + num_bytes > e.get_end())
+				continue;
+
+			// Keep frequently used ranges at the front.
+			if (i > 0) {
+				std::swap(dmi_ranges[i], dmi_ranges[i - 1]);
+				return &dmi_ranges[i - 1];
+			}
+			return &e;
+		}
+
+		return nullptr;
+	}
+
+	void request_dmi(uint64_t addr) {
+		tlm::tlm_generic_payload trans;
+		tlm::tlm_dmi dmi;
+
+		trans.set_command(tlm::TLM_READ_COMMAND);
+		trans.set_address(addr);
+		if (!isock->get_direct_mem_ptr(trans, dmi) || !dmi.is_read_write_allowed())
+			return;
+
+		dmi_ranges.push_back(MemoryDMI::create_start_end_mapping(dmi.get_dmi_ptr(), dmi.get_start_address(),
+		                                                         dmi.get_end_address() + 1));
+	}
+
+	void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end) {
+		auto overlaps = [start, end](MemoryDMI &e) {
+			return e.get_start() <= end && start < e.get_end();
+		};
+		dmi_ranges.erase(std::remove_if(dmi_ranges.begin(), dmi_ranges.end(), overlaps), dmi_ranges.end());
 	}
 
     uint64_t v2p(uint64_t vaddr, MemoryAccessType type) override {
@@ -90,7 +135,8 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
         return mmu->translate_virtual_to_physical_addr(vaddr, type);
     }
 
-	inline void _do_transaction(tlm::tlm_generic_payload &trans) {
+	inline void _do_transaction(tlm::tlm_generic_payload &trans, bool dmi = false) {
+		auto trans_addr = trans.get_address();
 		sc_core::sc_time local_delay = quantum_keeper.get_local_time();
 		isock->b_transport(trans, local_delay);
 
@@ -109,9 +155,14 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 				throw std::runtime_error("TLM command must be read or write");
 		}
 
+		// Accesses crossing the end of a granted range (e.g. instructions
+		// spanning two pages) are never served by it. Don't request the
+		// same range again, these accesses use transactions instead.
+		if (dmi && trans.is_dmi_allowed() && !find_dmi(trans_addr, 1))
+			request_dmi(trans_addr);
 	}
 
-	void _do_transaction(tlm::tlm_command cmd, uint64_t addr, Concolic &data, size_t num_bytes) {
+	void _do_transaction(tlm::tlm_command cmd, uint64_t addr, Concolic &data, size_t num_bytes, bool dmi = false) {
 		uint8_t buf[num_bytes];
 		if (cmd == tlm::TLM_WRITE_COMMAND)
 			iss.solver.BVCToBytes(data, &buf[0], num_bytes);
@@ -130,7 +181,7 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 			trans.set_extension(extension);
 		}
 
-		_do_transaction(trans);
+		_do_transaction(trans, dmi);
 		if (cmd == tlm::TLM_WRITE_COMMAND)
 			return;
 
@@ -143,7 +194,7 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 		}
 	}
 
-	inline void _do_transaction(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, size_t num_bytes) {
+	inline void _do_transaction(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, size_t num_bytes, bool dmi = false) {
 		tlm::tlm_generic_payload trans;
 		trans.set_command(cmd);
 		trans.set_address(addr);
@@ -151,42 +202,38 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 		trans.set_data_length(num_bytes);
 		trans.set_response_status(tlm::TLM_OK_RESPONSE);
 
-		_do_transaction(trans);
+		_do_transaction(trans, dmi);
 	}
 
 	template <typename T>
-	inline T concrete_load_data(uint64_t addr) {
+	inline T concrete_load_data(uint64_t addr, bool dmi) {
 		// NOTE: a DMI load will not context switch (SystemC) and not modify the memory, hence should be able to
 		// postpone the lock after the dmi access
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
 
-		for (auto &e : dmi_ranges) {
-			if (e.contains(addr)) {
-				quantum_keeper.inc(dmi_access_delay);
-				return e.load<T>(addr);
-			}
+		MemoryDMI *e = dmi ? find_dmi(addr, sizeof(T)) : nullptr;
+		if (e) {
+			quantum_keeper.inc(dmi_access_delay);
+			return e->load<T>(addr);
 		}
 
 		T ans;
-		_do_transaction(tlm::TLM_READ_COMMAND, addr, (uint8_t *)&ans, sizeof(T));
+		_do_transaction(tlm::TLM_READ_COMMAND, addr, (uint8_t *)&ans, sizeof(T), dmi);
 		return ans;
 	}
 
 	template <typename T>
-	inline void concrete_store_data(uint64_t addr, T value) {
+	inline void concrete_store_data(uint64_t addr, T value, bool dmi) {
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
+		iss.decode_cache.invalidate(addr, sizeof(T));
 
-		bool done = false;
-		for (auto &e : dmi_ranges) {
-			if (e.contains(addr)) {
-				quantum_keeper.inc(dmi_access_delay);
-				e.store(addr, value);
-				done = true;
-			}
+		MemoryDMI *e = dmi ? find_dmi(addr, sizeof(T)) : nullptr;
+		if (e) {
+			quantum_keeper.inc(dmi_access_delay);
+			e->store(addr, value);
+		} else {
+			_do_transaction(tlm::TLM_WRITE_COMMAND, addr, (uint8_t *)&value, sizeof(T), dmi);
 		}
-
-		if (!done)
-			_do_transaction(tlm::TLM_WRITE_COMMAND, addr, (uint8_t *)&value, sizeof(T));
 #if 0
 		atomic_unlock();
 #endif
@@ -194,44 +241,59 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 
 	void symbolic_store_data(Concolic addr, Concolic data, size_t num_bytes) override {
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
-		// XXX: DMI is currently not supported for symbolic values.
 
 		auto caddr = iss.solver.getValue<uint32_t>(addr->concrete);
 		auto vaddr = v2p(caddr, STORE);
+		iss.decode_cache.invalidate(vaddr, num_bytes);
+
+		// Symbolic values must be stored through the target, this
+		// invalidates the DMI range of the affected page.
+		MemoryDMI *e = (data_dmi && !data->symbolic.has_value()) ? find_dmi(vaddr, num_bytes) : nullptr;
+		if (e) {
+			quantum_keeper.inc(dmi_access_delay);
+			iss.solver.BVCToBytes(data, e->get_mem_ptr_to_global_addr<uint8_t>(vaddr), num_bytes);
+			return;
+		}
 
-		_do_transaction(tlm::TLM_WRITE_COMMAND, vaddr, data, num_bytes);
+		_do_transaction(tlm::TLM_WRITE_COMMAND, vaddr, data, num_bytes, data_dmi);
 	}
 
 	Concolic symbolic_load_data(Concolic addr, size_t num_bytes) override {
 		bus_lock->wait_for_access_rights(iss.get_hart_id());
-		// XXX: DMI is currently not supported for symbolic values.
 
 		auto caddr = iss.solver.getValue<uint32_t>(addr->concrete);
 		auto vaddr = v2p(caddr, STORE);
 
+		// Ranges are only granted for pages without symbolic bytes.
+		MemoryDMI *e = data_dmi ? find_dmi(vaddr, num_bytes) : nullptr;
+		if (e) {
+			quantum_keeper.inc(dmi_access_delay);
+			return iss.solver.BVC(e->get_mem_ptr_to_global_addr<uint8_t>(vaddr), num_bytes);
+		}
+
 		Concolic data;
-		_do_transaction(tlm::TLM_READ_COMMAND, vaddr, data, num_bytes);
+		_do_transaction(tlm::TLM_READ_COMMAND, vaddr, data, num_bytes, data_dmi);
 		return data;
 	}
 
     template <typename T>
     inline T _load_data(uint64_t addr) {
-        return concrete_load_data<T>(v2p(addr, LOAD));
+        return concrete_load_data<T>(v2p(addr, LOAD), data_dmi);
     }
 
     template <typename T>
     inline void _store_data(uint64_t addr, T value) {
-        concrete_store_data(v2p(addr, STORE), value);
+        concrete_store_data(v2p(addr, STORE), value, data_dmi);
     }
 
     uint64_t mmu_load_pte64(uint64_t addr) override {
-        return concrete_load_data<uint64_t>(addr);
+        return concrete_load_data<uint64_t>(addr, data_dmi);
     }
     uint64_t mmu_load_pte32(uint64_t addr) override {
-        return concrete_load_data<uint32_t>(addr);
+        return concrete_load_data<uint32_t>(addr, data_dmi);
     }
     void mmu_store_pte32(uint64_t addr, uint32_t value) override {
-        concrete_store_data(addr, value);
+        concrete_store_data(addr, value, data_dmi);
     }
 
     void flush_tlb() override {
@@ -239,7 +301,7 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
     }
 
     uint32_t load_instr(uint64_t addr) override {
-        return concrete_load_data<uint32_t>(v2p(addr, FETCH));
+        return concrete_load_data<uint32_t>(v2p(addr, FETCH), instr_dmi);
     }
 
 #if 0
@@ -74,7 +74,7 @@ struct data_memory_if {
 	virtual void atomic_unlock() = 0;
 #endif
 
-	typedef std::shared_ptr<clover::ConcolicValue> Concolic;
+	typedef clover::Ref<clover::ConcolicValue> Concolic;
 
 	virtual void symbolic_store_data(Concolic addr, Concolic data, size_t num_bytes) = 0;
 	virtual Concolic symbolic_load_data(Concolic addr, size_t num_bytes) = 0;
@@ -23,6 +23,7 @@
 #ifndef RISCV_ISA_BUS_H
 #define RISCV_ISA_BUS_H
 
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 
@@ -51,14 +52,17 @@ template <unsigned int NR_OF_INITIATORS, unsigned int NR_OF_TARGETS>
 struct SimpleBus : sc_core::sc_module {
 	std::array<tlm_utils::simple_target_socket<SimpleBus>, NR_OF_INITIATORS> tsocks;
 
-	std::array<tlm_utils::simple_initiator_socket<SimpleBus>, NR_OF_TARGETS> isocks;
+	std::array<tlm_utils::simple_initiator_socket_tagged<SimpleBus>, NR_OF_TARGETS> isocks;
 	std::array<PortMapping *, NR_OF_TARGETS> ports;
 
 	SimpleBus(sc_core::sc_module_name) {
 		for (auto &s : tsocks) {
 			s.register_b_transport(this, &SimpleBus::transport);
 			s.register_transport_dbg(this, &SimpleBus::transport_dbg);
+			s.register_get_direct_mem_ptr(this, &SimpleBus::get_direct_mem_ptr);
 		}
+		for (unsigned i = 0; i < NR_OF_TARGETS; ++i)
+			isocks[i].register_invalidate_direct_mem_ptr(this, &SimpleBus::invalidate_direct_mem_ptr, i);
 	}
 
 	int decode(uint64_t addr) {
@@ -94,6 +98,33 @@ struct SimpleBus : sc_core::sc_module {
 		trans.set_address(ports[id]->global_to_local(addr));
 		return isocks[id]->transport_dbg(trans);
 	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi) {
+		auto addr = trans.get_address();
+		auto id = decode(addr);
+
+		if (id < 0)
+			return false;
+
+		auto port = ports[id];
+		trans.set_address(port->global_to_local(addr));
+		bool granted = isocks[id]->get_direct_mem_ptr(trans, dmi);
+
+		// Translate the range back, it must not exceed the port.
+		auto end = std::min<sc_dt::uint64>(dmi.get_end_address(), port->end - port->start);
+		dmi.set_start_address(dmi.get_start_address() + port->start);
+		dmi.set_end_address(end + port->start);
+
+		return granted;
+	}
+
+	void invalidate_direct_mem_ptr(int id, sc_dt::uint64 start, sc_dt::uint64 end) {
+		auto port = ports[id];
+		end = std::min<sc_dt::uint64>(end, port->end - port->start);
+
+		for (auto &s : tsocks)
+			s->invalidate_direct_mem_ptr(start + port->start, end + port->start);
+	}
 };
 
 #include "core/common/bus_lock_if.h"
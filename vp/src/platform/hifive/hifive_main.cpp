@@ -153,6 +153,7 @@ int sc_main(int argc, char **argv) {
 	SymbolicCTRL symctrl("symctrl", core);
 	SimpleMemory flash("Flash", opt.flash_size);
 	ELFLoader loader(opt.input_program.c_str());
+	symbolic_context.coverage.init(loader);
 	SimpleBus<2, 15> bus("SimpleBus");
 	CombinedMemoryInterface iss_mem_if("MemoryInterface", core);
 	SyscallHandler sys("SyscallHandler");
@@ -185,10 +186,8 @@ int sc_main(int argc, char **argv) {
 
 	instr_memory_if *instr_mem_if = &iss_mem_if;
 	data_memory_if *data_mem_if = &iss_mem_if;
-	if (opt.use_instr_dmi || opt.use_data_dmi) {
-		std::cerr << "DMI not supported by symbolic execution backend" << std::endl;
-		return 1;
-	}
+	iss_mem_if.instr_dmi = opt.use_instr_dmi;
+	iss_mem_if.data_dmi = opt.use_data_dmi;
 
 	bus.ports[0] = new PortMapping(opt.flash_start_addr, opt.flash_end_addr);
 	bus.ports[1] = new PortMapping(opt.dram_start_addr, opt.dram_end_addr);
@@ -67,7 +67,7 @@ SymbolicUART::SymbolicUART(sc_core::sc_module_name, uint32_t irqsrc, SymbolicCon
 	slip_mode = _slip_mode;
 	tsock.register_b_transport(this, &SymbolicUART::transport);
 
-	std::shared_ptr<clover::ConcolicValue> v;
+	clover::Ref<clover::ConcolicValue> v;
 	while ((v = fmt.next_byte()))
 		rx_fifo.push(v);
 
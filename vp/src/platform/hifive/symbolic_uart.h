@@ -73,8 +73,8 @@ private:
 	SymbolicFormat &fmt;
 
 	uint32_t irq;
-	std::shared_ptr<clover::ConcolicValue> slip_end;
-	std::shared_ptr<clover::ConcolicValue> slip_esc_esc;
+	clover::Ref<clover::ConcolicValue> slip_end;
+	clover::Ref<clover::ConcolicValue> slip_esc_esc;
 	uint32_t rxdata_end;
 
 	// memory mapped configuration registers
@@ -87,7 +87,7 @@ private:
 	uint32_t div = 0;
 
 	AsyncEvent asyncEvent;
-	std::queue<std::shared_ptr<clover::ConcolicValue>> rx_fifo;
+	std::queue<clover::Ref<clover::ConcolicValue>> rx_fifo;
 
 	vp::map::LocalRouter router = {"SymbolicUART"};
 
@@ -107,6 +107,7 @@ int sc_main(int argc, char **argv) {
 	SymbolicSensor sensor("sensor", symbolic_context);
 	SymbolicCTRL symctrl("symctrl", core);
 	ELFLoader loader(opt.input_program.c_str());
+	symbolic_context.coverage.init(loader);
 	SimpleBus<2, 5> bus("SimpleBus");
 	SyscallHandler sys("SyscallHandler");
 	CLINT<1> clint("CLINT");
@@ -117,10 +118,8 @@ int sc_main(int argc, char **argv) {
 
 	instr_memory_if *instr_mem_if = &core_mem_if;
 	data_memory_if *data_mem_if = &core_mem_if;
-	if (opt.use_instr_dmi || opt.use_data_dmi) {
-		std::cerr << "DMI not supported by symbolic execution backend" << std::endl;
-		return 1;
-	}
+	core_mem_if.instr_dmi = opt.use_instr_dmi;
+	core_mem_if.data_dmi = opt.use_data_dmi;
 
 	loader.load_executable_image(mem, opt.mem_size, opt.mem_start_addr, false);
 	core.init(instr_mem_if, data_mem_if, &clint, loader.get_entrypoint(), rv32_align_address(opt.mem_end_addr));
@@ -38,16 +38,16 @@ BitVector::BitVector(const klee::Array *array)
 	this->expr = klee::Expr::createTempRead(array, bitsize);
 }
 
-std::shared_ptr<BitVector>
+Ref<BitVector>
 BitVector::eqTrue(void)
 {
 	auto expr = klee::EqExpr::alloc(this->expr, klee::ConstantExpr::alloc(1, klee::Expr::Bool));
-	return std::make_shared<BitVector>(BitVector(expr));
+	return Ref<BitVector>(new BitVector(expr));
 }
 
-std::shared_ptr<BitVector>
+Ref<BitVector>
 BitVector::eqFalse(void)
 {
 	auto expr = klee::EqExpr::alloc(this->expr, klee::ConstantExpr::alloc(0, klee::Expr::Bool));
-	return std::make_shared<BitVector>(BitVector(expr));
+	return Ref<BitVector>(new BitVector(expr));
 }
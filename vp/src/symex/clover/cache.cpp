@@ -0,0 +1,415 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <sstream>
+#include <system_error>
+
+#include <clover/clover.h>
+
+#include <klee/Expr/ExprUtil.h>
+#include <klee/Solver/SolverImpl.h>
+
+using namespace clover;
+
+/* The cache file starts with a magic value followed by a sequence of
+ * records. Each record consists of a header and the cached value. */
+
+#define CACHE_MAGIC "CLVQC001"
+#define MAGIC_SIZE (sizeof(CACHE_MAGIC) - 1)
+
+// Files are mapped in multiples of this size to avoid remapping them
+// for every appended record. The mapping may exceed the file size.
+#define MAP_CHUNK ((size_t)64 << 20)
+
+struct RecordHeader {
+	uint64_t hi, lo;
+	uint32_t size;
+	uint32_t check;
+};
+
+/* Query kinds, part of the key. */
+enum QueryKind : char {
+	QUERY_TRUTH = 'T',
+	QUERY_VALUES = 'V',
+};
+
+static uint64_t
+mix(uint64_t h)
+{
+	// Finalizer of splitmix64.
+	h = (h ^ (h >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	h = (h ^ (h >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return h ^ (h >> 31);
+}
+
+static uint32_t
+checksum(const RecordHeader &hdr, const uint8_t *value)
+{
+	auto digest = QueryCache::digest(std::string((const char *)value, hdr.size));
+	return (uint32_t)(digest.lo ^ hdr.lo ^ hdr.hi ^ hdr.size);
+}
+
+QueryCache::~QueryCache(void)
+{
+	if (map)
+		munmap((void *)map, mapsize);
+	if (fd != -1)
+		close(fd);
+}
+
+void
+QueryCache::open(std::string _path)
+{
+	path = _path;
+	reopen();
+
+	lock(LOCK_EX);
+	struct stat st;
+	if (fstat(fd, &st) == -1)
+		throw std::system_error(errno, std::generic_category());
+
+	if (st.st_size == 0) {
+		if (write(fd, CACHE_MAGIC, MAGIC_SIZE) != MAGIC_SIZE)
+			throw std::system_error(errno, std::generic_category());
+	} else {
+		char magic[MAGIC_SIZE];
+		if (pread(fd, magic, MAGIC_SIZE, 0) != MAGIC_SIZE ||
+		    memcmp(magic, CACHE_MAGIC, MAGIC_SIZE))
+			throw std::runtime_error("invalid query cache file: " + path);
+	}
+	lock(LOCK_UN);
+
+	scanned = MAGIC_SIZE;
+	refresh();
+}
+
+bool
+QueryCache::isOpen(void)
+{
+	return !path.empty();
+}
+
+void
+QueryCache::reopen(void)
+{
+	// Locks obtained through flock(2) are associated with the open file
+	// description, which is shared with processes forked from the owner.
+	// Each process therefore requires its own file descriptor.
+	if (fd != -1)
+		close(fd);
+
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd == -1)
+		throw std::system_error(errno, std::generic_category(), path);
+	owner = getpid();
+}
+
+void
+QueryCache::lock(int operation)
+{
+	if (owner != getpid())
+		reopen();
+
+	while (flock(fd, operation) == -1) {
+		if (errno != EINTR)
+			throw std::system_error(errno, std::generic_category());
+	}
+}
+
+void
+QueryCache::remap(size_t size)
+{
+	if (size <= mapsize)
+		return;
+
+	if (map)
+		munmap((void *)map, mapsize);
+
+	mapsize = ((size + MAP_CHUNK - 1) / MAP_CHUNK) * MAP_CHUNK;
+	void *p = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED) {
+		map = nullptr;
+		mapsize = 0;
+		throw std::system_error(errno, std::generic_category());
+	}
+
+	map = (const uint8_t *)p;
+}
+
+void
+QueryCache::scan(size_t size)
+{
+	remap(size);
+
+	while (scanned + sizeof(RecordHeader) <= size) {
+		RecordHeader hdr;
+		memcpy(&hdr, map + scanned, sizeof(hdr));
+
+		size_t value = scanned + sizeof(hdr);
+		if (hdr.size > size - value || checksum(hdr, map + value) != hdr.check)
+			break; // incomplete record
+
+		index[Digest{hdr.hi, hdr.lo}] = std::make_pair(value, (size_t)hdr.size);
+		scanned = value + hdr.size;
+	}
+}
+
+void
+QueryCache::refresh(void)
+{
+	struct stat st;
+
+	if (fstat(fd, &st) == -1)
+		throw std::system_error(errno, std::generic_category());
+	if ((size_t)st.st_size <= scanned)
+		return;
+
+	// Records are only complete while no writer holds the lock.
+	lock(LOCK_SH);
+	if (fstat(fd, &st) == -1)
+		throw std::system_error(errno, std::generic_category());
+	scan(st.st_size);
+	lock(LOCK_UN);
+}
+
+QueryCache::Digest
+QueryCache::digest(const std::string &data)
+{
+	// Two independently seeded lanes, combined into a 128 bit digest.
+	uint64_t hi = UINT64_C(0x9e3779b97f4a7c15), lo = UINT64_C(0x6a09e667f3bcc909);
+
+	size_t i;
+	for (i = 0; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data.data() + i, sizeof(word));
+
+		hi = mix(hi ^ word) + i;
+		lo = mix(lo + word) ^ hi;
+	}
+
+	uint64_t tail = data.size();
+	for (; i < data.size(); i++)
+		tail = (tail << 8) | (uint8_t)data[i];
+
+	hi = mix(hi ^ tail);
+	lo = mix(lo + tail) ^ hi;
+	return Digest{hi, lo};
+}
+
+std::string
+QueryCache::key(char kind, const klee::Query &query,
+                const std::vector<const klee::Array *> *objects)
+{
+	std::ostringstream stream;
+	ExprWriter writer(true);
+
+	// Arrays for which values are requested are numbered first,
+	// this establishes the order of values stored for the query.
+	stream.put(kind);
+	if (objects) {
+		for (auto array : *objects)
+			writer.writeArray(stream, array);
+	}
+
+	for (auto constraint : query.constraints)
+		writer.write(stream, Ref<BitVector>(new BitVector(constraint)));
+	writer.write(stream, Ref<BitVector>(new BitVector(query.expr)));
+
+	return stream.str();
+}
+
+std::optional<std::string>
+QueryCache::lookup(const Digest &digest)
+{
+	auto it = index.find(digest);
+	if (it == index.end()) {
+		refresh(); // added by other processes?
+		it = index.find(digest);
+		if (it == index.end())
+			return std::nullopt;
+	}
+
+	auto offset = it->second.first;
+	auto size = it->second.second;
+	return std::string((const char *)map + offset, size);
+}
+
+void
+QueryCache::insert(const Digest &digest, const std::string &value)
+{
+	RecordHeader hdr;
+	struct stat st;
+
+	lock(LOCK_EX);
+	if (fstat(fd, &st) == -1)
+		throw std::system_error(errno, std::generic_category());
+	scan(st.st_size);
+	if (index.count(digest)) {
+		lock(LOCK_UN);
+		return; // added by another process
+	}
+
+	// Discard an incomplete record at the end of the file.
+	if (scanned < (size_t)st.st_size && ftruncate(fd, scanned) == -1)
+		throw std::system_error(errno, std::generic_category());
+
+	hdr.hi = digest.hi;
+	hdr.lo = digest.lo;
+	hdr.size = value.size();
+	hdr.check = checksum(hdr, (const uint8_t *)value.data());
+
+	std::string record((const char *)&hdr, sizeof(hdr));
+	record += value;
+
+	size_t off = 0;
+	while (off < record.size()) {
+		ssize_t r = pwrite(fd, record.data() + off, record.size() - off, scanned + off);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		}
+		off += r;
+	}
+
+	scan(scanned + record.size());
+	lock(LOCK_UN);
+}
+
+/* Solver layer answering queries from a QueryCache. Only successful
+ * results are cached, i.e. timeouts are retried by subsequent runs. */
+class CacheSolverImpl : public klee::SolverImpl {
+private:
+	klee::Solver *solver;
+	QueryCache &cache;
+
+public:
+	CacheSolverImpl(klee::Solver *_solver, QueryCache &_cache)
+	    : solver(_solver), cache(_cache)
+	{
+		return;
+	}
+
+	~CacheSolverImpl(void)
+	{
+		delete solver;
+	}
+
+	bool computeTruth(const klee::Query &query, bool &isValid);
+	bool computeValue(const klee::Query &query, klee::ref<klee::Expr> &result);
+	bool computeInitialValues(const klee::Query &query,
+	                          const std::vector<const klee::Array *> &objects,
+	                          std::vector<std::vector<unsigned char>> &values,
+	                          bool &hasSolution);
+
+	SolverRunStatus getOperationStatusCode(void)
+	{
+		return solver->impl->getOperationStatusCode();
+	}
+
+	char *getConstraintLog(const klee::Query &query)
+	{
+		return solver->impl->getConstraintLog(query);
+	}
+
+	void setCoreSolverTimeout(klee::time::Span timeout)
+	{
+		solver->impl->setCoreSolverTimeout(timeout);
+	}
+};
+
+bool
+CacheSolverImpl::computeTruth(const klee::Query &query, bool &isValid)
+{
+	if (!cache.isOpen())
+		return solver->impl->computeTruth(query, isValid);
+
+	auto digest = QueryCache::digest(QueryCache::key(QUERY_TRUTH, query, nullptr));
+	auto value = cache.lookup(digest);
+	if (value.has_value() && value->size() == 1) {
+		isValid = (*value)[0];
+		return true;
+	}
+
+	if (!solver->impl->computeTruth(query, isValid))
+		return false;
+
+	cache.insert(digest, std::string(1, (char)isValid));
+	return true;
+}
+
+bool
+CacheSolverImpl::computeValue(const klee::Query &query, klee::ref<klee::Expr> &result)
+{
+	std::vector<const klee::Array *> objects;
+	std::vector<std::vector<unsigned char>> values;
+	bool hasSolution;
+
+	// Like Z3SolverImpl::computeValue(), compute an assignment for
+	// the arrays used by the expression and evaluate it.
+	klee::findSymbolicObjects(query.expr, objects);
+	if (!computeInitialValues(query.withFalse(), objects, values, hasSolution))
+		return false;
+	assert(hasSolution && "state has invalid constraint set");
+
+	klee::Assignment a(objects, values);
+	result = a.evaluate(query.expr);
+	return true;
+}
+
+bool
+CacheSolverImpl::computeInitialValues(const klee::Query &query,
+                                      const std::vector<const klee::Array *> &objects,
+                                      std::vector<std::vector<unsigned char>> &values,
+                                      bool &hasSolution)
+{
+	if (!cache.isOpen())
+		return solver->impl->computeInitialValues(query, objects, values, hasSolution);
+
+	auto digest = QueryCache::digest(QueryCache::key(QUERY_VALUES, query, &objects));
+	auto value = cache.lookup(digest);
+	if (value.has_value() && !value->empty()) {
+		// Values are stored in the order of the requested arrays.
+		size_t total = 1;
+		for (auto array : objects)
+			total += array->size;
+
+		hasSolution = (*value)[0];
+		if (!hasSolution)
+			return true;
+
+		if (value->size() == total) {
+			size_t off = 1;
+			for (auto array : objects) {
+				values.emplace_back(value->begin() + off, value->begin() + off + array->size);
+				off += array->size;
+			}
+			return true;
+		}
+	}
+
+	if (!solver->impl->computeInitialValues(query, objects, values, hasSolution))
+		return false;
+
+	std::string result(1, (char)hasSolution);
+	if (hasSolution) {
+		for (auto &v : values)
+			result.append(v.begin(), v.end());
+	}
+
+	cache.insert(digest, result);
+	return true;
+}
+
+klee::Solver *
+QueryCache::createSolver(klee::Solver *solver)
+{
+	return new klee::Solver(new CacheSolverImpl(solver, *this));
+}
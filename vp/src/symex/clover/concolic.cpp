@@ -4,146 +4,147 @@
 
 using namespace clover;
 
-#define BINARY_OPERATOR(NAME, FN)                                                                 \
-	std::shared_ptr<ConcolicValue>                                                            \
-	NAME(std::shared_ptr<ConcolicValue> other)                                                \
-	{                                                                                         \
-		auto expr = builder->FN(concrete->expr, other->concrete->expr);                   \
-		auto bvv = std::make_shared<BitVector>(BitVector(expr));                          \
-                                                                                                  \
-		if (this->symbolic.has_value() || other->symbolic.has_value()) {                  \
-			auto bvs_this = this->symbolic.value_or(this->concrete);                  \
-			auto bvs_other = other->symbolic.value_or(other->concrete);               \
-                                                                                                  \
-			auto expr = builder->FN(bvs_this->expr, bvs_other->expr);                 \
-			auto bvs = std::make_shared<BitVector>(BitVector(expr));                  \
-                                                                                                  \
-			return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs)); \
-		} else {                                                                          \
-			return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));      \
-		}                                                                                 \
+/* The concrete part is always computed natively, KLEE expressions
+ * are only built if at least one operand has a symbolic part. */
+#define BINARY_OPERATOR(NAME, FN)                                                           \
+	Ref<ConcolicValue>                                                                  \
+	ConcolicValue::NAME(Ref<ConcolicValue> other)                                       \
+	{                                                                                   \
+		auto value = concrete.NAME(other->concrete);                                \
+                                                                                            \
+		if (this->symbolic.has_value() || other->symbolic.has_value()) {            \
+			auto expr = builder->FN(this->getExpr(), other->getExpr());         \
+			auto bvs = Ref<BitVector>(new BitVector(expr));                     \
+                                                                                            \
+			return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));  \
+		} else {                                                                    \
+			return Ref<ConcolicValue>(new ConcolicValue(builder, value));       \
+		}                                                                           \
 	}
 
-ConcolicValue::ConcolicValue(klee::ExprBuilder *_builder, std::shared_ptr<BitVector> _concrete, std::optional<std::shared_ptr<BitVector>> _symbolic)
+ConcolicValue::ConcolicValue(klee::ExprBuilder *_builder, ConcreteValue _concrete, std::optional<Ref<BitVector>> _symbolic)
     : concrete(_concrete), symbolic(_symbolic), builder(_builder)
 {
-	assert(isa<klee::ConstantExpr>(concrete->expr) &&
-	       "concrete part of ConcolicValue must be a ConstantExpr");
+	return;
 }
 
 unsigned
 ConcolicValue::getWidth(void)
 {
 	if (symbolic.has_value())
-		assert(concrete->expr->getWidth() == (*symbolic)->expr->getWidth());
-	return concrete->expr->getWidth();
+		assert(concrete.getWidth() == (*symbolic)->expr->getWidth());
+	return concrete.getWidth();
 }
 
-BINARY_OPERATOR(ConcolicValue::eq, Eq)
-BINARY_OPERATOR(ConcolicValue::ne, Ne)
-BINARY_OPERATOR(ConcolicValue::lshl, Shl)
-BINARY_OPERATOR(ConcolicValue::lshr, LShr)
-BINARY_OPERATOR(ConcolicValue::ashr, AShr)
-BINARY_OPERATOR(ConcolicValue::add, Add)
-BINARY_OPERATOR(ConcolicValue::mul, Mul)
-BINARY_OPERATOR(ConcolicValue::udiv, UDiv)
-BINARY_OPERATOR(ConcolicValue::sdiv, SDiv)
-BINARY_OPERATOR(ConcolicValue::urem, URem)
-BINARY_OPERATOR(ConcolicValue::srem, SRem)
-BINARY_OPERATOR(ConcolicValue::sub, Sub)
-BINARY_OPERATOR(ConcolicValue::slt, Slt)
-BINARY_OPERATOR(ConcolicValue::sge, Sge)
-BINARY_OPERATOR(ConcolicValue::ule, Ule)
-BINARY_OPERATOR(ConcolicValue::ult, Ult)
-BINARY_OPERATOR(ConcolicValue::uge, Uge)
-BINARY_OPERATOR(ConcolicValue::band, And)
-BINARY_OPERATOR(ConcolicValue::bor, Or)
-BINARY_OPERATOR(ConcolicValue::bxor, Xor)
-BINARY_OPERATOR(ConcolicValue::concat, Concat)
-
-std::shared_ptr<ConcolicValue>
+klee::ref<klee::Expr>
+ConcolicValue::getExpr(void)
+{
+	if (symbolic.has_value())
+		return (*symbolic)->expr;
+	return concrete.toExpr();
+}
+
+BINARY_OPERATOR(eq, Eq)
+BINARY_OPERATOR(ne, Ne)
+BINARY_OPERATOR(lshl, Shl)
+BINARY_OPERATOR(lshr, LShr)
+BINARY_OPERATOR(ashr, AShr)
+BINARY_OPERATOR(add, Add)
+BINARY_OPERATOR(mul, Mul)
+BINARY_OPERATOR(udiv, UDiv)
+BINARY_OPERATOR(sdiv, SDiv)
+BINARY_OPERATOR(urem, URem)
+BINARY_OPERATOR(srem, SRem)
+BINARY_OPERATOR(sub, Sub)
+BINARY_OPERATOR(slt, Slt)
+BINARY_OPERATOR(sge, Sge)
+BINARY_OPERATOR(ule, Ule)
+BINARY_OPERATOR(ult, Ult)
+BINARY_OPERATOR(uge, Uge)
+BINARY_OPERATOR(band, And)
+BINARY_OPERATOR(bor, Or)
+BINARY_OPERATOR(bxor, Xor)
+BINARY_OPERATOR(concat, Concat)
+
+Ref<ConcolicValue>
 ConcolicValue::bnot(void)
 {
-	auto expr = builder->Not(concrete->expr);
-	auto bvv = std::make_shared<BitVector>(BitVector(expr));
+	auto value = concrete.bnot();
 
 	if (this->symbolic.has_value()) {
 		auto expr = builder->Not((*symbolic)->expr);
-		auto bvs = std::make_shared<BitVector>(BitVector(expr));
+		auto bvs = Ref<BitVector>(new BitVector(expr));
 
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));
 	} else {
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value));
 	}
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ConcolicValue::extract(unsigned offset, klee::Expr::Width width)
 {
-	auto expr = builder->Extract(concrete->expr, offset, width);
-	auto bvv = std::make_shared<BitVector>(BitVector(expr));
+	auto value = concrete.extract(offset, width);
 
 	if (this->symbolic.has_value()) {
 		auto expr = builder->Extract((*symbolic)->expr, offset, width);
-		auto bvs = std::make_shared<BitVector>(BitVector(expr));
+		auto bvs = Ref<BitVector>(new BitVector(expr));
 
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));
 	} else {
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value));
 	}
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ConcolicValue::sext(klee::Expr::Width width)
 {
-	auto expr = builder->SExt(concrete->expr, width);
-	auto bvv = std::make_shared<BitVector>(BitVector(expr));
+	// Values are immutable, extending to the same width is a no-op.
+	if (width == getWidth())
+		return Ref<ConcolicValue>(this);
+
+	auto value = concrete.sext(width);
 
 	if (this->symbolic.has_value()) {
 		auto expr = builder->SExt((*symbolic)->expr, width);
-		auto bvs = std::make_shared<BitVector>(BitVector(expr));
+		auto bvs = Ref<BitVector>(new BitVector(expr));
 
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));
 	} else {
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value));
 	}
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ConcolicValue::zext(klee::Expr::Width width)
 {
-	auto expr = builder->ZExt(concrete->expr, width);
-	auto bvv = std::make_shared<BitVector>(BitVector(expr));
+	// Values are immutable, extending to the same width is a no-op.
+	if (width == getWidth())
+		return Ref<ConcolicValue>(this);
+
+	auto value = concrete.zext(width);
 
 	if (this->symbolic.has_value()) {
 		auto expr = builder->ZExt((*symbolic)->expr, width);
-		auto bvs = std::make_shared<BitVector>(BitVector(expr));
+		auto bvs = Ref<BitVector>(new BitVector(expr));
 
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));
 	} else {
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value));
 	}
 }
 
-std::shared_ptr<ConcolicValue>
-ConcolicValue::select(std::shared_ptr<ConcolicValue> texpr, std::shared_ptr<ConcolicValue> fexpr)
+Ref<ConcolicValue>
+ConcolicValue::select(Ref<ConcolicValue> texpr, Ref<ConcolicValue> fexpr)
 {
-	auto toExpr = [](std::shared_ptr<ConcolicValue> c) {
-		if (c->symbolic.has_value())
-			return (*(c->symbolic))->expr;
-		else
-			return c->concrete->expr;
-	};
-
-	auto expr = builder->Select(concrete->expr, texpr->concrete->expr, fexpr->concrete->expr);
-	auto bvv = std::make_shared<BitVector>(BitVector(expr));
+	auto value = concrete.select(texpr->concrete, fexpr->concrete);
 
 	if (this->symbolic.has_value()) {
-		auto expr = builder->Select((*symbolic)->expr, toExpr(texpr), toExpr(fexpr));
-		auto bvs = std::make_shared<BitVector>(BitVector(expr));
+		auto expr = builder->Select((*symbolic)->expr, texpr->getExpr(), fexpr->getExpr());
+		auto bvs = Ref<BitVector>(new BitVector(expr));
 
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv, bvs));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value, bvs));
 	} else {
-		return std::make_shared<ConcolicValue>(ConcolicValue(builder, bvv));
+		return Ref<ConcolicValue>(new ConcolicValue(builder, value));
 	}
 }
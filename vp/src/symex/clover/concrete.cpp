@@ -0,0 +1,208 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+/* The inline operations below must match the semantics of the
+ * corresponding klee::ConstantExpr operations (i.e. of llvm::APInt).
+ * Operations whose result is not representable inline, or which are
+ * undefined (division by zero), are delegated to KLEE. */
+
+#define SLOW_BINARY(FN) \
+	ConcreteValue(toExpr()->FN(other.toExpr()))
+
+#define BINARY_OPERATOR(NAME, FN, EXPR)                             \
+	ConcreteValue                                               \
+	ConcreteValue::NAME(const ConcreteValue &other) const       \
+	{                                                           \
+		if (!isInline() || !other.isInline())               \
+			return SLOW_BINARY(FN);                     \
+                                                                    \
+		assert(width == other.width);                       \
+		uint64_t a = value, b = other.value;                \
+		return ConcreteValue((EXPR) & mask(width), width);  \
+	}
+
+#define COMPARE_OPERATOR(NAME, FN, EXPR)                            \
+	ConcreteValue                                               \
+	ConcreteValue::NAME(const ConcreteValue &other) const       \
+	{                                                           \
+		if (!isInline() || !other.isInline())               \
+			return SLOW_BINARY(FN);                     \
+                                                                    \
+		assert(width == other.width);                       \
+		uint64_t a = value, b = other.value;                \
+		return ConcreteValue((EXPR), klee::Expr::Bool);     \
+	}
+
+static inline uint64_t
+mask(klee::Expr::Width width)
+{
+	return (width >= 64) ? UINT64_MAX : (UINT64_C(1) << width) - 1;
+}
+
+static inline int64_t
+sign(uint64_t value, klee::Expr::Width width)
+{
+	unsigned shift = 64 - width;
+	return (int64_t)(value << shift) >> shift;
+}
+
+ConcreteValue::ConcreteValue(uint64_t _value, klee::Expr::Width _width)
+    : width(_width), value(_value)
+{
+	assert(width > 0 && width <= 64);
+	assert((value & ~mask(width)) == 0);
+}
+
+ConcreteValue::ConcreteValue(const klee::ref<klee::ConstantExpr> &ce)
+    : width(ce->getWidth()), value(0)
+{
+	if (isInline())
+		value = ce->getZExtValue();
+	else
+		wide = ce;
+}
+
+uint64_t
+ConcreteValue::getZExtValue(unsigned bits) const
+{
+	assert(width <= bits && "Value may be out of range!");
+	return value;
+}
+
+klee::ref<klee::ConstantExpr>
+ConcreteValue::toExpr(void) const
+{
+	if (!isInline())
+		return wide;
+	return klee::ConstantExpr::create(value, width);
+}
+
+COMPARE_OPERATOR(eq, Eq, a == b)
+COMPARE_OPERATOR(ne, Ne, a != b)
+COMPARE_OPERATOR(ult, Ult, a < b)
+COMPARE_OPERATOR(ule, Ule, a <= b)
+COMPARE_OPERATOR(uge, Uge, a >= b)
+COMPARE_OPERATOR(slt, Slt, sign(a, width) < sign(b, width))
+COMPARE_OPERATOR(sge, Sge, sign(a, width) >= sign(b, width))
+
+BINARY_OPERATOR(add, Add, a + b)
+BINARY_OPERATOR(sub, Sub, a - b)
+BINARY_OPERATOR(mul, Mul, a * b)
+BINARY_OPERATOR(band, And, a & b)
+BINARY_OPERATOR(bor, Or, a | b)
+BINARY_OPERATOR(bxor, Xor, a ^ b)
+
+// Shift amounts exceeding the width shift out all bits.
+BINARY_OPERATOR(lshl, Shl, (b >= width) ? 0 : a << b)
+BINARY_OPERATOR(lshr, LShr, (b >= width) ? 0 : a >> b)
+BINARY_OPERATOR(ashr, AShr, (uint64_t)(sign(a, width) >> ((b >= width) ? width - 1 : b)))
+
+ConcreteValue
+ConcreteValue::udiv(const ConcreteValue &other) const
+{
+	if (!isInline() || !other.isInline() || other.value == 0)
+		return SLOW_BINARY(UDiv);
+
+	assert(width == other.width);
+	return ConcreteValue(value / other.value, width);
+}
+
+ConcreteValue
+ConcreteValue::urem(const ConcreteValue &other) const
+{
+	if (!isInline() || !other.isInline() || other.value == 0)
+		return SLOW_BINARY(URem);
+
+	assert(width == other.width);
+	return ConcreteValue(value % other.value, width);
+}
+
+ConcreteValue
+ConcreteValue::sdiv(const ConcreteValue &other) const
+{
+	if (!isInline() || !other.isInline() || other.value == 0)
+		return SLOW_BINARY(SDiv);
+
+	assert(width == other.width);
+	int64_t a = sign(value, width), b = sign(other.value, width);
+
+	// Dividing the minimum value by -1 overflows, the result wraps.
+	if (b == -1)
+		return ConcreteValue((0 - value) & mask(width), width);
+	return ConcreteValue((uint64_t)(a / b) & mask(width), width);
+}
+
+ConcreteValue
+ConcreteValue::srem(const ConcreteValue &other) const
+{
+	if (!isInline() || !other.isInline() || other.value == 0)
+		return SLOW_BINARY(SRem);
+
+	assert(width == other.width);
+	int64_t a = sign(value, width), b = sign(other.value, width);
+
+	if (b == -1)
+		return ConcreteValue(0, width);
+	return ConcreteValue((uint64_t)(a % b) & mask(width), width);
+}
+
+ConcreteValue
+ConcreteValue::concat(const ConcreteValue &other) const
+{
+	if (!isInline() || !other.isInline() || width + other.width > 64)
+		return SLOW_BINARY(Concat);
+
+	return ConcreteValue((value << other.width) | other.value, width + other.width);
+}
+
+ConcreteValue
+ConcreteValue::bnot(void) const
+{
+	if (!isInline())
+		return ConcreteValue(toExpr()->Not());
+
+	return ConcreteValue(~value & mask(width), width);
+}
+
+ConcreteValue
+ConcreteValue::extract(unsigned offset, klee::Expr::Width _width) const
+{
+	if (!isInline() || _width > 64)
+		return ConcreteValue(toExpr()->Extract(offset, _width));
+
+	// Like klee::ConstantExpr::Extract, bits beyond the width of
+	// this value are filled with the sign bit.
+	uint64_t v = (uint64_t)(sign(value, width) >> ((offset >= width) ? width - 1 : offset));
+	return ConcreteValue(v & mask(width) & mask(_width), _width);
+}
+
+ConcreteValue
+ConcreteValue::sext(klee::Expr::Width _width) const
+{
+	if (!isInline() || _width > 64)
+		return ConcreteValue(toExpr()->SExt(_width));
+
+	return ConcreteValue((uint64_t)sign(value, width) & mask(_width), _width);
+}
+
+ConcreteValue
+ConcreteValue::zext(klee::Expr::Width _width) const
+{
+	if (!isInline() || _width > 64)
+		return ConcreteValue(toExpr()->ZExt(_width));
+
+	return ConcreteValue(value & mask(_width), _width);
+}
+
+ConcreteValue
+ConcreteValue::select(const ConcreteValue &texpr, const ConcreteValue &fexpr) const
+{
+	assert(width == klee::Expr::Bool);
+	assert(texpr.width == fexpr.width);
+
+	return (value) ? texpr : fexpr;
+}
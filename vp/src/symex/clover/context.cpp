@@ -17,6 +17,12 @@ ExecutionContext::getPrevStore(void)
 	return last_run; // Might be empty
 }
 
+void
+ExecutionContext::onFirstSymbolic(std::function<void(void)> fn)
+{
+	firstSymbolic = fn;
+}
+
 bool
 ExecutionContext::setupNewValues(ConcreteStore store)
 {
@@ -42,7 +48,7 @@ ExecutionContext::setupNewValues(Trace &trace)
 	return setupNewValues(trace.getStore(*assign));
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ExecutionContext::getSymbolicWord(std::string name)
 {
 	IntValue concrete = findRemoveOrRandom<uint32_t>(name);
@@ -53,10 +59,10 @@ ExecutionContext::getSymbolicWord(std::string name)
  * function does not overlap and store the value directly in the map
  * without splitting it into single bytes as this split is already
  * done by the ConcolicMemory::store function */
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ExecutionContext::getSymbolicBytes(std::string name, size_t size)
 {
-	std::shared_ptr<ConcolicValue> result = nullptr;
+	Ref<ConcolicValue> result = nullptr;
 
 	for (size_t i = 0; i < size; i++) {
 		std::string bname = name + ":byte" + std::to_string(i);
@@ -72,7 +78,7 @@ ExecutionContext::getSymbolicBytes(std::string name, size_t size)
 	return result;
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 ExecutionContext::getSymbolicByte(std::string name)
 {
 	IntValue concrete = findRemoveOrRandom<uint8_t>(name);
@@ -3,7 +3,9 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 #include <klee/Expr/ArrayCache.h>
 #include <klee/Expr/Assignment.h>
@@ -11,11 +13,17 @@
 #include <klee/Expr/ExprBuilder.h>
 #include <klee/Solver/Solver.h>
 
+#include <array>
+#include <bitset>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
+#include <queue>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace clover {
 
@@ -35,7 +43,188 @@ public:
 	}
 };
 
-class BitVector {
+/* Base class for objects managed through Ref. The reference count is
+ * not atomic, such objects must not be shared between threads. */
+class RefCounted {
+private:
+	template <typename T>
+	friend class Ref;
+
+	unsigned refCount = 0;
+
+protected:
+	RefCounted(void) = default;
+
+	// A copy is a distinct object which is not referenced yet.
+	RefCounted(const RefCounted &)
+	{
+		return;
+	}
+
+	RefCounted &operator=(const RefCounted &)
+	{
+		return *this;
+	}
+};
+
+/* Intrusive reference-counting pointer for objects derived from
+ * RefCounted. Unlike std::shared_ptr, it requires neither a separate
+ * control block nor atomic operations when copied. */
+template <typename T>
+class Ref {
+private:
+	T *ptr;
+
+	static void release(T *p)
+	{
+		if (p && --p->refCount == 0)
+			delete p;
+	}
+
+public:
+	Ref(void)
+	    : ptr(nullptr)
+	{
+		return;
+	}
+
+	Ref(std::nullptr_t)
+	    : ptr(nullptr)
+	{
+		return;
+	}
+
+	explicit Ref(T *p)
+	    : ptr(p)
+	{
+		if (ptr)
+			ptr->refCount++;
+	}
+
+	Ref(const Ref &r)
+	    : ptr(r.ptr)
+	{
+		if (ptr)
+			ptr->refCount++;
+	}
+
+	Ref(Ref &&r) noexcept
+	    : ptr(r.ptr)
+	{
+		r.ptr = nullptr;
+	}
+
+	~Ref(void)
+	{
+		release(ptr);
+	}
+
+	Ref &operator=(const Ref &r)
+	{
+		if (r.ptr)
+			r.ptr->refCount++;
+		release(ptr);
+		ptr = r.ptr;
+		return *this;
+	}
+
+	Ref &operator=(Ref &&r) noexcept
+	{
+		if (this != &r) {
+			release(ptr);
+			ptr = r.ptr;
+			r.ptr = nullptr;
+		}
+		return *this;
+	}
+
+	T *get(void) const
+	{
+		return ptr;
+	}
+
+	T &operator*(void) const
+	{
+		return *ptr;
+	}
+
+	T *operator->(void) const
+	{
+		return ptr;
+	}
+
+	explicit operator bool(void) const
+	{
+		return ptr != nullptr;
+	}
+
+	bool operator==(const Ref &r) const
+	{
+		return ptr == r.ptr;
+	}
+
+	bool operator!=(const Ref &r) const
+	{
+		return ptr != r.ptr;
+	}
+};
+
+/* Allocator for objects of the given size which are created and
+ * destroyed at a high rate, e.g. for each executed instruction. Freed
+ * blocks are kept on a free list and reused, memory is allocated in
+ * chunks and never returned to the system. Not thread-safe. */
+template <size_t Size>
+class Pool {
+private:
+	union Block {
+		Block *next;
+		alignas(std::max_align_t) char data[Size];
+	};
+
+	static constexpr size_t CHUNK_BLOCKS = 4096;
+	static inline Block *freeList = nullptr;
+
+	static void refill(void)
+	{
+		Block *chunk = static_cast<Block *>(::operator new(sizeof(Block) * CHUNK_BLOCKS));
+		for (size_t i = 0; i < CHUNK_BLOCKS; i++) {
+			chunk[i].next = freeList;
+			freeList = &chunk[i];
+		}
+	}
+
+public:
+	static void *alloc(void)
+	{
+		if (!freeList)
+			refill();
+
+		Block *block = freeList;
+		freeList = block->next;
+		return block;
+	}
+
+	static void free(void *p)
+	{
+		Block *block = static_cast<Block *>(p);
+		block->next = freeList;
+		freeList = block;
+	}
+};
+
+/* Class-specific allocation functions which use a Pool. */
+#define CLOVER_POOL_ALLOCATED(CLASS)                          \
+	static void *operator new(size_t size)                 \
+	{                                                      \
+		assert(size == sizeof(CLASS));                 \
+		return Pool<sizeof(CLASS)>::alloc();           \
+	}                                                      \
+	static void operator delete(void *p)                   \
+	{                                                      \
+		Pool<sizeof(CLASS)>::free(p);                  \
+	}
+
+class BitVector : public RefCounted {
 public:
 	klee::ref<klee::Expr> expr;
 
@@ -44,81 +233,275 @@ public:
 	BitVector(IntValue value);
 	BitVector(const klee::Array *array);
 
-	std::shared_ptr<BitVector> eqTrue(void);
-	std::shared_ptr<BitVector> eqFalse(void);
+	Ref<BitVector> eqTrue(void);
+	Ref<BitVector> eqFalse(void);
+
+	CLOVER_POOL_ALLOCATED(BitVector)
 
 	friend class ConcolicValue;
 	friend class Solver;
 	friend class Trace;
 };
 
-class ConcolicValue {
+/* Concrete part of a ConcolicValue. Values of up to 64 bits, i.e. all
+ * values handled by the ISS, are stored inline and operations on them
+ * are performed natively without allocating KLEE expressions. Wider
+ * values (e.g. concatenated DMA buffers) are stored as ConstantExpr. */
+class ConcreteValue {
+private:
+	klee::Expr::Width width;
+	uint64_t value;
+	klee::ref<klee::ConstantExpr> wide;
+
 public:
-	std::shared_ptr<BitVector> concrete;
-	std::optional<std::shared_ptr<BitVector>> symbolic;
+	ConcreteValue(uint64_t _value, klee::Expr::Width _width);
+	ConcreteValue(const klee::ref<klee::ConstantExpr> &ce);
+
+	klee::Expr::Width getWidth(void) const
+	{
+		return width;
+	}
+
+	bool isInline(void) const
+	{
+		return width <= 64;
+	}
+
+	uint64_t getZExtValue(unsigned bits = 64) const;
+	klee::ref<klee::ConstantExpr> toExpr(void) const;
+
+	ConcreteValue eq(const ConcreteValue &other) const;
+	ConcreteValue ne(const ConcreteValue &other) const;
+	ConcreteValue lshl(const ConcreteValue &other) const;
+	ConcreteValue lshr(const ConcreteValue &other) const;
+	ConcreteValue ashr(const ConcreteValue &other) const;
+	ConcreteValue add(const ConcreteValue &other) const;
+	ConcreteValue mul(const ConcreteValue &other) const;
+	ConcreteValue udiv(const ConcreteValue &other) const;
+	ConcreteValue sdiv(const ConcreteValue &other) const;
+	ConcreteValue urem(const ConcreteValue &other) const;
+	ConcreteValue srem(const ConcreteValue &other) const;
+	ConcreteValue sub(const ConcreteValue &other) const;
+	ConcreteValue slt(const ConcreteValue &other) const;
+	ConcreteValue sge(const ConcreteValue &other) const;
+	ConcreteValue ult(const ConcreteValue &other) const;
+	ConcreteValue ule(const ConcreteValue &other) const;
+	ConcreteValue uge(const ConcreteValue &other) const;
+	ConcreteValue band(const ConcreteValue &other) const;
+	ConcreteValue bor(const ConcreteValue &other) const;
+	ConcreteValue bxor(const ConcreteValue &other) const;
+	ConcreteValue concat(const ConcreteValue &other) const;
+	ConcreteValue bnot(void) const;
+	ConcreteValue extract(unsigned offset, klee::Expr::Width width) const;
+	ConcreteValue sext(klee::Expr::Width width) const;
+	ConcreteValue zext(klee::Expr::Width width) const;
+	ConcreteValue select(const ConcreteValue &texpr, const ConcreteValue &fexpr) const;
+};
+
+class ConcolicValue : public RefCounted {
+public:
+	ConcreteValue concrete;
+	std::optional<Ref<BitVector>> symbolic;
 
 	unsigned getWidth(void);
 
-	std::shared_ptr<ConcolicValue> eq(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> ne(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> lshl(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> lshr(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> ashr(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> add(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> mul(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> udiv(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> sdiv(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> urem(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> srem(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> sub(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> slt(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> sge(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> ult(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> ule(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> uge(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> band(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> bor(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> bxor(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> concat(std::shared_ptr<ConcolicValue> other);
-	std::shared_ptr<ConcolicValue> bnot(void);
-	std::shared_ptr<ConcolicValue> extract(unsigned offset, klee::Expr::Width width);
-	std::shared_ptr<ConcolicValue> sext(klee::Expr::Width width);
-	std::shared_ptr<ConcolicValue> zext(klee::Expr::Width width);
-	std::shared_ptr<ConcolicValue> select(std::shared_ptr<ConcolicValue> texpr, std::shared_ptr<ConcolicValue> fexpr);
+	Ref<ConcolicValue> eq(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> ne(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> lshl(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> lshr(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> ashr(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> add(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> mul(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> udiv(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> sdiv(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> urem(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> srem(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> sub(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> slt(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> sge(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> ult(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> ule(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> uge(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> band(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> bor(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> bxor(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> concat(Ref<ConcolicValue> other);
+	Ref<ConcolicValue> bnot(void);
+	Ref<ConcolicValue> extract(unsigned offset, klee::Expr::Width width);
+	Ref<ConcolicValue> sext(klee::Expr::Width width);
+	Ref<ConcolicValue> zext(klee::Expr::Width width);
+	Ref<ConcolicValue> select(Ref<ConcolicValue> texpr, Ref<ConcolicValue> fexpr);
+
+	CLOVER_POOL_ALLOCATED(ConcolicValue)
 
 private:
 	klee::ExprBuilder *builder = NULL;
 
 	ConcolicValue(klee::ExprBuilder *_builder,
-	              std::shared_ptr<BitVector> _concrete,
-	              std::optional<std::shared_ptr<BitVector>> _symbolic = std::nullopt);
+	              ConcreteValue _concrete,
+	              std::optional<Ref<BitVector>> _symbolic = std::nullopt);
+
+	/* Symbolic part or, if there is none, the concrete part as expression. */
+	klee::ref<klee::Expr> getExpr(void);
 
 	/* The solver acts as a factory for ConcolicValue */
 	friend class Solver;
 };
 
+/* Persistent cache of solver results, shared by all processes using
+ * the same cache file (e.g. parallel workers or later campaigns).
+ * Queries are identified by a digest of their serialized form, in
+ * which arrays are numbered in order of appearance instead of named.
+ * The file is append-only and mapped into memory. Records are only
+ * appended while holding an exclusive lock on the file, incomplete
+ * records (e.g. of a crashed process) are discarded. */
+class QueryCache {
+public:
+	struct Digest {
+		uint64_t hi, lo;
+
+		bool operator==(const Digest &other) const
+		{
+			return hi == other.hi && lo == other.lo;
+		}
+	};
+
+private:
+	struct DigestHash {
+		size_t operator()(const Digest &digest) const
+		{
+			return digest.lo;
+		}
+	};
+
+	std::string path;
+	pid_t owner = -1;
+	int fd = -1;
+
+	const uint8_t *map = nullptr;
+	size_t mapsize = 0;
+
+	// Offset up to which records have been added to the index.
+	size_t scanned = 0;
+	std::unordered_map<Digest, std::pair<size_t, size_t>, DigestHash> index;
+
+	void reopen(void);
+	void lock(int operation);
+	void remap(size_t size);
+	void scan(size_t size);
+	void refresh(void);
+
+public:
+	~QueryCache(void);
+
+	void open(std::string _path);
+	bool isOpen(void);
+
+	static Digest digest(const std::string &data);
+	static std::string key(char kind, const klee::Query &query,
+	                       const std::vector<const klee::Array *> *objects);
+
+	std::optional<std::string> lookup(const Digest &digest);
+	void insert(const Digest &digest, const std::string &value);
+
+	/* Create a solver which answers queries from this cache, if it
+	 * has been opened, and forwards all other queries to the given
+	 * solver. Results of the latter are added to the cache. */
+	klee::Solver *createSolver(klee::Solver *solver);
+};
+
+/* Profile of the queries issued to the solver chain. Each layer of
+ * the chain is wrapped to count the queries it receives and the time
+ * spent in it, including the time spent in the layers below. A layer
+ * answered a query itself if it was not forwarded to the next layer.
+ * Additionally, the size of each query and the slowest queries are
+ * recorded. Queries are attributed to the branch which was negated,
+ * see setOrigin(). Profiling is disabled by default. */
+class SolverProfile {
+public:
+	struct Layer {
+		std::string name;
+		uint64_t queries = 0;
+		double time = 0; // milliseconds
+	};
+
+	struct QueryInfo {
+		uint32_t pc;
+		double time; // milliseconds
+		size_t constraints, nodes, arrays;
+		size_t layer; // innermost layer reached
+	};
+
+	/* Histogram with power of two buckets, bucket i counts values
+	 * within [2^(i-1), 2^i) and bucket 0 counts zero values. */
+	typedef std::array<uint64_t, 33> Histogram;
+
+private:
+	bool enabled = false;
+
+	// Layers in order of construction, i.e. core solver first.
+	std::vector<Layer> layers;
+
+	// State of the query currently passing through the chain.
+	unsigned depth = 0;
+	uint32_t origin = 0;
+	QueryInfo current;
+
+	uint64_t queries = 0;
+	Histogram constraints = {}, nodes = {}, arrays = {};
+	std::vector<QueryInfo> slowest;
+
+public:
+	void enable(void);
+	bool isEnabled(void);
+
+	/* Invoked by wrapped layers before and after each query. */
+	void enter(size_t layer, const klee::Query &query);
+	void leave(size_t layer, double time);
+
+	/* Attribute the next query to the branch at the given pc. */
+	void setOrigin(uint32_t pc);
+
+	/* Wrap a layer of the solver chain, layers must be wrapped
+	 * starting with the core solver. */
+	klee::Solver *wrap(std::string name, klee::Solver *solver);
+
+	/* Write the profile, along with all KLEE statistics, as JSON. */
+	void write(std::ostream &stream);
+};
+
 class Solver {
 private:
 	klee::Solver *solver;
 	klee::ArrayCache array_cache;
 	klee::ExprBuilder *builder = NULL;
+	QueryCache cache;
+	SolverProfile profile;
+
+	friend class ExprReader;
 
 public:
 	Solver(klee::Solver *_solver = NULL);
 	~Solver(void);
 
 	void setTimeout(klee::time::Span timeout);
+
+	/* Persist results of queries to the core solver in the given file. */
+	void setQueryCache(std::string path);
+
+	SolverProfile &getProfile(void);
 	std::optional<klee::Assignment> getAssignment(const klee::Query &query);
 
 	bool eval(const klee::Query &query);
-	std::shared_ptr<ConcolicValue> BVC(std::optional<std::string> name, IntValue value);
+	Ref<ConcolicValue> BVC(std::optional<std::string> name, IntValue value);
+	Ref<ConcolicValue> BVC(ConcreteValue value);
 
 	/* Methods for converting between concolic values and uint8_t buffers */
-	std::shared_ptr<ConcolicValue> BVC(uint8_t *buf, size_t buflen, bool lsb = false);
-	void BVCToBytes(std::shared_ptr<ConcolicValue> value, uint8_t *buf, size_t buflen);
+	Ref<ConcolicValue> BVC(uint8_t *buf, size_t buflen, bool lsb = false);
+	void BVCToBytes(Ref<ConcolicValue> value, uint8_t *buf, size_t buflen);
 
-	typedef std::map<std::string, std::shared_ptr<BitVector>> Env;
-	std::shared_ptr<BitVector> fromString(Env env, std::string kquery);
+	typedef std::map<std::string, Ref<BitVector>> Env;
+	Ref<BitVector> fromString(Env env, std::string kquery);
 
 	template <typename T>
 	T evalValue(const klee::Query &query)
@@ -133,7 +516,7 @@ public:
 
 	/* Convert the concrete part of a ConcolicValue to a C type. */
 	template <typename T>
-	T getValue(std::shared_ptr<BitVector> bv)
+	T getValue(Ref<BitVector> bv)
 	{
 		// Since we don't have constraints here, these function
 		// only works on ConstantExpr as provided by ->concrete.
@@ -142,28 +525,206 @@ public:
 
 		return ce->getZExtValue(sizeof(T) * 8);
 	}
+
+	template <typename T>
+	T getValue(const ConcreteValue &value)
+	{
+		return value.getZExtValue(sizeof(T) * 8);
+	}
 };
 
+/* Byte-addressed memory holding concolic values. Memory is organized
+ * in pages, each page stores the concrete part of all its bytes in a
+ * flat array. Symbolic parts are kept in a shadow which is only
+ * allocated for pages that currently hold symbolic bytes, accesses to
+ * fully concrete pages therefore amount to copying bytes. */
 class ConcolicMemory {
-private:
+public:
 	typedef uint32_t Addr;
 
+	static constexpr unsigned PAGE_BITS = 12;
+	static constexpr size_t PAGE_SIZE = (size_t)1 << PAGE_BITS;
+
+	/* Invoked with the start address and size of a page when direct
+	 * access to it, see getDirectPage(), is no longer permitted. */
+	typedef std::function<void(Addr, size_t)> InvalidateHandler;
+
+private:
+	class Shadow {
+	public:
+		std::array<Ref<ConcolicValue>, PAGE_SIZE> bytes;
+		size_t count = 0;
+	};
+
+	class Page {
+	public:
+		uint8_t data[PAGE_SIZE] = {0};
+
+		// Symbolic bytes, nullptr if the page is fully concrete.
+		std::unique_ptr<Shadow> shadow;
+
+		// Bytes written at least once, reading other bytes
+		// emits a warning. Tracked until all bytes were written.
+		std::bitset<PAGE_SIZE> initialized;
+		bool complete = false;
+
+		// Direct access to data has been granted.
+		bool direct = false;
+
+		bool isInitialized(size_t off, size_t len);
+		void setInitialized(size_t off, size_t len);
+		void setSymbolic(size_t off, Ref<ConcolicValue> byte);
+		void clearSymbolic(size_t off, size_t len);
+	};
+
 	Solver &solver;
-	std::unordered_map<Addr, std::shared_ptr<ConcolicValue>> data;
+	std::unordered_map<Addr, std::unique_ptr<Page>> pages;
+
+	// Most recently accessed page.
+	Addr lastPageNum = 0;
+	Page *lastPage = nullptr;
+
+	InvalidateHandler invalidate;
+
+	Page *getPage(Addr addr, bool create);
+	void revokeDirect(Addr num, Page *page);
+	void warnUninitialized(Addr addr);
+
+	Ref<ConcolicValue> loadByte(Addr addr);
+	void storeByte(Addr addr, Ref<ConcolicValue> byte);
 
 public:
 	ConcolicMemory(Solver &_solver);
 	void reset(void);
 
-	std::shared_ptr<ConcolicValue> load(Addr addr, unsigned bytesize);
-	std::shared_ptr<ConcolicValue> load(std::shared_ptr<ConcolicValue> addr, unsigned bytesize);
-
-	void store(Addr addr, std::shared_ptr<ConcolicValue> value, unsigned bytesize);
-	void store(std::shared_ptr<ConcolicValue> addr, std::shared_ptr<ConcolicValue> value, unsigned bytesize);
+	Ref<ConcolicValue> load(Addr addr, unsigned bytesize);
+	Ref<ConcolicValue> load(Ref<ConcolicValue> addr, unsigned bytesize);
+
+	void store(Addr addr, Ref<ConcolicValue> value, unsigned bytesize);
+	void store(Ref<ConcolicValue> addr, Ref<ConcolicValue> value, unsigned bytesize);
+
+	/* Access the concrete parts of the given bytes. Storing concrete
+	 * bytes discards the symbolic parts previously stored there.
+	 * Unlike load(), uninitialized bytes are read as zero silently. */
+	void loadConcrete(Addr addr, uint8_t *buf, size_t len);
+	void storeConcrete(Addr addr, const uint8_t *buf, size_t len);
+
+	/* Returns true if none of the given bytes is symbolic. */
+	bool isConcrete(Addr addr, size_t len);
+
+	/* Returns true if the page containing the given address does
+	 * not hold any symbolic bytes. */
+	bool isConcretePage(Addr addr);
+
+	/* Returns a pointer to the concrete bytes of the page containing
+	 * the given address, or nullptr if the page holds symbolic bytes.
+	 * The pointer may be used to access the page directly until the
+	 * invalidation handler is invoked for it, i.e. until a symbolic
+	 * byte is stored in the page. Bytes accessed directly are not
+	 * tracked, the entire page is considered initialized. */
+	uint8_t *getDirectPage(Addr addr);
+	void setInvalidate(InvalidateHandler handler);
 };
 
 typedef std::map<std::string, IntValue> ConcreteStore;
 
+/**
+ * Determines the order in which branches of the execution tree are
+ * negated by Trace::findNewPath(). All branches for which only one
+ * direction has been explored so far (the candidates) are kept in a
+ * priority queue, the candidate with the highest priority is negated
+ * first. Priorities are re-evaluated lazily when a candidate is taken
+ * from the queue, the priority of a candidate must therefore never
+ * increase over time.
+ */
+class SearchStrategy {
+public:
+	class Candidate {
+	public:
+		// Address of the branch instruction.
+		uint32_t addr;
+
+		// Unexplored direction of the branch.
+		bool condition;
+
+		// Number of branches on the path from the root to this branch.
+		size_t depth;
+
+		// Number of negated branches on the path to this branch,
+		// i.e. the generation as used by SAGE-style searches.
+		unsigned generation;
+	};
+
+	virtual ~SearchStrategy(void);
+
+	/* Invoked for each branch added to the execution tree. */
+	virtual void visit(uint32_t addr, bool condition);
+
+	/* Invoked when the given candidate was selected for negation. */
+	virtual void negated(const Candidate &candidate);
+
+	virtual int64_t priority(const Candidate &candidate) = 0;
+
+	/* Create strategy by name, returns nullptr for the default strategy
+	 * (a random walk of the execution tree preferring upper nodes).
+	 * Throws std::invalid_argument for unknown names. */
+	static std::unique_ptr<SearchStrategy> create(std::string name);
+	static const std::vector<std::string> &names(void);
+};
+
+/**
+ * Negation statistics for branch sites, i.e. branch instructions.
+ *
+ * Loops over symbolic data add many nodes with the same address to the
+ * execution tree, negating each of them rarely yields new behaviour. A
+ * site is saturated once its negations exceed the configured budget.
+ * Optionally, the negations of a site decay by the given factor with
+ * each negation performed at any site, allowing saturated sites to
+ * recover while the exploration progresses elsewhere.
+ */
+class BranchSites {
+public:
+	class Stats {
+	public:
+		uint64_t negations = 0;
+
+		// Negations which yielded a new path, i.e. were satisfiable.
+		uint64_t paths = 0;
+	};
+
+private:
+	class Site {
+	public:
+		Stats stats;
+
+		// Decayed number of negations at the time of the given tick.
+		double load = 0;
+		uint64_t tick = 0;
+	};
+
+	std::unordered_map<uint32_t, Site> sites;
+	uint64_t ticks = 0;
+
+	uint64_t budget = 0; // unlimited
+	double decay = 1.0;
+
+	double getLoad(const Site &site) const;
+
+public:
+	/* Limit the negations per site, a budget of zero disables the
+	 * limit. The decay factor must be in the interval (0, 1]. */
+	void setBudget(uint64_t budget, double decay = 1.0);
+	bool hasDecay(void) const;
+
+	void negated(uint32_t addr, bool newPath);
+	bool isSaturated(uint32_t addr) const;
+	double getLoad(uint32_t addr) const;
+
+	/* Statistics for all negated sites, most negated sites first. */
+	std::vector<std::pair<uint32_t, Stats>> getStats(void) const;
+	size_t countSaturated(void) const;
+};
+
 /**
  * The Tracer fullfills two tasks:
  *
@@ -181,7 +742,7 @@ class Trace {
 private:
 	class Branch {
 	public:
-		std::shared_ptr<BitVector> bv;
+		Ref<BitVector> bv;
 
 		// Track if this negation of this branch condition was
 		// already attempted. Negating the same branch condition
@@ -194,7 +755,11 @@ private:
 		// branch condition represented by the BitVector.
 		uint32_t addr;
 
-		Branch(std::shared_ptr<BitVector> _bv, bool _wasNegated, uint32_t _addr)
+		// Candidate of a saturated branch site which is skipped
+		// by Node::randomUnnegated(), see Trace::selectCandidate().
+		bool deferred = false;
+
+		Branch(Ref<BitVector> _bv, bool _wasNegated, uint32_t _addr)
 		    : bv(_bv), wasNegated(_wasNegated), addr(_addr)
 		{
 			return;
@@ -211,9 +776,20 @@ private:
 		Node *true_branch;
 		Node *false_branch;
 
-		Node(void);
+		// Used to reconstruct the path to a node in the frontier.
+		Node *parent;
+		size_t depth;
+		unsigned generation;
+
+		Node(Node *_parent = nullptr, unsigned _generation = 0);
 		bool isPlaceholder(void);
 
+		/* Returns true if only one direction of this node has been
+		 * explored and the node has not been negated yet. */
+		bool isCandidate(void);
+		SearchStrategy::Candidate toCandidate(void);
+		Path getPath(void);
+
 		/* Returns a seemingly random unnegated path to a branch
 		 * condition in the Tree but prefers nodes in the upper
 		 * Tree. The caller is responsible for updating the wasNegated
@@ -231,30 +807,107 @@ private:
 	Node *pathCondsRoot;
 	Node *pathCondsCurrent;
 
+public:
+	/* Function used to forward new path elements to a different
+	 * Trace instance which owns the execution tree, e.g. in a
+	 * different process. Receives condition, branch condition,
+	 * address, and whether the caller requires to know if the
+	 * owner added a new node to its tree (the return value). */
+	typedef std::function<bool(bool, Ref<BitVector>, uint32_t, bool)> ForwardFn;
+
+	/* Opaque position in the execution tree, see Trace::extend(). */
+	typedef Node *Cursor;
+
+private:
+	ForwardFn forward;
+
+	class FrontierEntry {
+	public:
+		int64_t priority;
+		uint64_t seq;
+		Node *node;
+
+		bool operator<(const FrontierEntry &other) const;
+	};
+
+	std::unique_ptr<SearchStrategy> strategy;
+	std::priority_queue<FrontierEntry> frontier;
+	uint64_t frontierSeq = 0;
+
+	int64_t getPriority(Node *node);
+	void pushCandidate(Node *node);
+	Node *nextCandidate(void);
+	void rebuildFrontier(void);
+
+	// Candidates of saturated branch sites, these are only negated
+	// once no candidate of an unsaturated branch site is left.
+	BranchSites sites;
+	std::vector<Node *> deferred;
+
+	Node *findNode(const Path &path);
+	bool isSaturated(Node *node);
+	void resumeDeferred(void);
+	Node *takeDeferred(void);
+	Node *selectCandidate(void);
+
+	static void deleteTree(Node *root);
+
 	/* Create new query for path in execution tree. */
 	klee::Query newQuery(klee::ConstraintSet &cs, Path &path);
 
 	/* Add a new node to the execution tree and the constraint set.*/
-	bool addBranch(std::shared_ptr<Branch> branch, bool condition);
+	bool addBranch(std::shared_ptr<Branch> branch, bool condition, bool needResult = false);
+	bool addBranch(Node *&current, std::shared_ptr<Branch> branch, bool condition);
 
 public:
 	Trace(Solver &_solver);
 	~Trace(void);
 	void reset(void);
 
+	/* Write the execution tree, including the negation state of all
+	 * branches, to the given stream. Trace::load() replaces the
+	 * execution tree with a tree previously written to a stream. */
+	void save(std::ostream &stream);
+	void load(std::istream &stream);
+
+	/* Use the given strategy for selecting branches to negate. */
+	void setStrategy(std::unique_ptr<SearchStrategy> strategy);
+
+	/* Negation statistics and budget of branch sites. */
+	BranchSites &getSites(void);
+
+	/* Forward path elements to a different execution tree instead
+	 * of adding them to the execution tree of this instance. */
+	void setForward(ForwardFn fn);
+
+	/* Add a path element, as passed to a ForwardFn, to this execution
+	 * tree. The cursor must initially be a nullptr and is advanced to
+	 * the position of the new path element afterwards. Returns true
+	 * if a new node was added to the tree. */
+	bool extend(Cursor &cursor, bool condition, Ref<BitVector> bv, uint32_t pc);
+
 	/* Add branch node to tree which can (potentially) be either true or false. */
-	void add(bool condition, std::shared_ptr<BitVector> bv, uint32_t pc);
+	void add(bool condition, Ref<BitVector> bv, uint32_t pc);
 
 	/* Enforce the given symbolic constraint to be always true.
 	 * Using this method requires handling thrown ::AssumeNotification
 	 * in the main execution loop. */
-	void assume(std::shared_ptr<BitVector> bv);
+	void assume(Ref<BitVector> bv);
 
 	/* Create query from BitVector with currently tracked constraints. */
-	klee::Query getQuery(std::shared_ptr<BitVector> bv);
+	klee::Query getQuery(Ref<BitVector> bv);
 
 	std::optional<klee::Assignment> findNewPath(void);
 	ConcreteStore getStore(const klee::Assignment &assign);
+
+	/* Position of the current execution in the execution tree. */
+	Cursor getCursor(void);
+
+	/* Negate all unnegated branches on the path leading to the given
+	 * position at once, as done by SAGE's generational search. Returns
+	 * the assignments for all satisfiable negations. Negated assume
+	 * conditions are left to findNewPath(). */
+	std::vector<klee::Assignment> findNewPaths(Cursor cursor);
 };
 
 class ExecutionContext {
@@ -267,11 +920,16 @@ private:
 
 	Solver &solver;
 
+	std::function<void(void)> firstSymbolic;
+
 	template <typename T>
 	IntValue findRemoveOrRandom(std::string name)
 	{
 		IntValue concrete;
 
+		if (last_run.empty() && firstSymbolic)
+			firstSymbolic();
+
 		auto iter = next_run.find(name);
 		if (iter != next_run.end()) {
 			concrete = (*iter).second;
@@ -289,12 +947,17 @@ public:
 	ExecutionContext(Solver &_solver);
 	ConcreteStore getPrevStore(void);
 
+	/* Register a function which is invoked once per execution before
+	 * the first symbolic value is created. Up to this point, the
+	 * execution does not depend on the concrete store. */
+	void onFirstSymbolic(std::function<void(void)> fn);
+
 	bool setupNewValues(ConcreteStore store);
 	bool setupNewValues(Trace &trace);
 
-	std::shared_ptr<ConcolicValue> getSymbolicWord(std::string name);
-	std::shared_ptr<ConcolicValue> getSymbolicBytes(std::string name, size_t size);
-	std::shared_ptr<ConcolicValue> getSymbolicByte(std::string name);
+	Ref<ConcolicValue> getSymbolicWord(std::string name);
+	Ref<ConcolicValue> getSymbolicBytes(std::string name, size_t size);
+	Ref<ConcolicValue> getSymbolicByte(std::string name);
 };
 
 class TestCase {
@@ -316,8 +979,54 @@ class TestCase {
 	};
 
 public:
-	static ConcreteStore fromFile(std::string name, std::ifstream &stream);
-	static void toFile(ConcreteStore store, std::ofstream &stream);
+	static ConcreteStore fromFile(std::string name, std::istream &stream);
+	static void toFile(ConcreteStore store, std::ostream &stream);
+};
+
+/* Binary serialization of BitVector expressions, e.g. for passing them
+ * between processes. Subexpressions which have already been written
+ * by an ExprWriter are only referenced, an ExprReader must therefore
+ * read expressions in the order they have been written. */
+class ExprWriter {
+private:
+	// The stored references ensure that the keys are not reused.
+	std::unordered_map<const klee::Expr *, std::pair<uint32_t, klee::ref<klee::Expr>>> exprs;
+	std::unordered_map<const klee::UpdateNode *, std::pair<uint32_t, klee::ref<klee::UpdateNode>>> updates;
+	std::unordered_map<const klee::Array *, uint32_t> arrays;
+
+	// Omit array names, arrays are only identified by their index.
+	bool anonymous;
+
+	uint32_t writeArray(std::ostream &stream, const klee::Array *array);
+	uint32_t writeUpdate(std::ostream &stream, const klee::ref<klee::UpdateNode> &un);
+	uint32_t writeExpr(std::ostream &stream, const klee::ref<klee::Expr> &expr);
+
+	friend class QueryCache;
+
+public:
+	ExprWriter(bool _anonymous = false);
+
+	void write(std::ostream &stream, Ref<BitVector> bv);
+};
+
+class ExprReader {
+private:
+	Solver &solver;
+
+	std::vector<klee::ref<klee::Expr>> exprs;
+	std::vector<klee::ref<klee::UpdateNode>> updates;
+	std::vector<const klee::Array *> arrays;
+
+	klee::ref<klee::Expr> getExpr(uint32_t idx);
+	klee::ref<klee::UpdateNode> getUpdate(uint32_t idx);
+
+	void readArray(std::istream &stream);
+	void readUpdate(std::istream &stream);
+	void readExpr(std::istream &stream);
+
+public:
+	ExprReader(Solver &_solver);
+	Ref<BitVector> read(std::istream &stream);
 };
 
 }; // namespace clover
@@ -274,8 +274,15 @@ namespace klee {
   /// fails.
   Solver *createDummySolver();
 
-  // Create a solver based on the supplied ``CoreSolverType``.
-  Solver *createCoreSolver(CoreSolverType cst);
+  // Create a solver based on the supplied ``CoreSolverType``. If
+  // ``incremental`` is set, solver state is reused across queries which
+  // share a prefix of their constraints (only supported by Z3).
+  Solver *createCoreSolver(CoreSolverType cst, bool incremental = false);
+
+  /// createZ3PortfolioSolver - Create a core solver which runs ``size``
+  /// differently configured Z3 instances in parallel threads and uses the
+  /// first answer.
+  Solver *createZ3PortfolioSolver(unsigned size, bool incremental = false);
 }
 
 #endif /* KLEE_SOLVER_H */
@@ -20,7 +20,10 @@
 
 namespace klee {
 
-Solver *createCoreSolver(CoreSolverType cst) {
+Solver *createCoreSolver(CoreSolverType cst, bool incremental) {
+  if (incremental && cst != Z3_SOLVER)
+    klee_warning("Incremental solving is only supported by Z3, ignoring");
+
   switch (cst) {
   case STP_SOLVER:
 #ifdef ENABLE_STP
@@ -42,8 +45,9 @@ Solver *createCoreSolver(CoreSolverType cst) {
     return createDummySolver();
   case Z3_SOLVER:
 #ifdef ENABLE_Z3
-    klee_message("Using Z3 solver backend");
-    return new Z3Solver();
+    klee_message("Using Z3 solver backend%s",
+                 incremental ? " (incremental)" : "");
+    return new Z3Solver(incremental);
 #else
     klee_message("Not compiled with Z3 support");
     return NULL;
@@ -55,4 +59,15 @@ Solver *createCoreSolver(CoreSolverType cst) {
     llvm_unreachable("Unsupported CoreSolverType");
   }
 }
+
+Solver *createZ3PortfolioSolver(unsigned size, bool incremental) {
+#ifdef ENABLE_Z3
+  klee_message("Using Z3 portfolio solver backend%s",
+               incremental ? " (incremental)" : "");
+  return new Z3PortfolioSolver(size, incremental);
+#else
+  klee_message("Not compiled with Z3 support");
+  return NULL;
+#endif
+}
 }
@@ -51,11 +51,36 @@ llvm::cl::opt<unsigned>
 
 #include "llvm/Support/ErrorHandling.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace klee {
 
+/// Z3Configuration - Configuration of a Z3 solver instance.
+struct Z3Configuration {
+  const char *logic;  ///< Create a solver for this logic, if set.
+  const char *tactic; ///< Create a solver from this tactic, if set.
+  unsigned seed;      ///< Random seed, 0 keeps Z3's default.
+};
+
+static const Z3Configuration defaultConfiguration = {NULL, NULL, 0};
+
+// Configurations used by Z3PortfolioSolver, in order. The first one is the
+// default configuration of Z3Solver. QF_BV is not included since queries
+// read symbolic values from arrays.
+static const Z3Configuration portfolioConfigurations[] = {
+    {/*logic=*/NULL, /*tactic=*/NULL, /*seed=*/0},
+    {/*logic=*/"QF_ABV", /*tactic=*/NULL, /*seed=*/1},
+    {/*logic=*/NULL, /*tactic=*/"qfaufbv", /*seed=*/2},
+    {/*logic=*/"QF_AUFBV", /*tactic=*/NULL, /*seed=*/3},
+};
+
 class Z3SolverImpl : public SolverImpl {
 private:
   Z3Builder *builder;
+  Z3Configuration config;
   time::Span timeout;
   SolverRunStatus runStatusCode;
   std::unique_ptr<llvm::raw_fd_ostream> dumpedQueriesFile;
@@ -63,14 +88,41 @@ private:
   // Parameter symbols
   ::Z3_symbol timeoutParamStrSymbol;
 
+  // Incremental mode: a single solver instance is used for all queries.
+  // Each constraint is asserted in its own scope, constraints are only
+  // popped when a query no longer shares them as prefix. Consecutive
+  // queries for the same path (e.g. negating sibling branches) thus
+  // only assert the constraints they do not have in common.
+  bool incremental;
+  ::Z3_solver incrementalSolver;
+  std::vector<ref<Expr> > assertedConstraints;
+
+  void assertConstraints(::Z3_solver theSolver, const ConstraintSet &constraints);
+  void assertConstantArrays(::Z3_solver theSolver, ConstantArrayFinder &finder);
+
+  // Running a query is split into three steps, which allows
+  // Z3PortfolioSolverImpl to only perform the check in parallel.
+  ::Z3_solver mkSolver();
+  ::Z3_solver prepareSolver(const Query &);
+  bool finishSolver(::Z3_solver theSolver, ::Z3_lbool satisfiable,
+                    const std::vector<const Array *> *objects,
+                    std::vector<std::vector<unsigned char> > *values,
+                    bool &hasSolution);
+  void releaseSolver(::Z3_solver theSolver);
+  void resetIncrementalSolver();
+
   bool internalRunSolver(const Query &,
                          const std::vector<const Array *> *objects,
                          std::vector<std::vector<unsigned char> > *values,
                          bool &hasSolution);
   bool validateZ3Model(::Z3_solver &theSolver, ::Z3_model &theModel);
 
+  friend class Z3PortfolioSolverImpl;
+
 public:
-  Z3SolverImpl();
+  Z3SolverImpl(bool incremental,
+               const Z3Configuration &config = defaultConfiguration,
+               bool logInteraction = true);
   ~Z3SolverImpl();
 
   char *getConstraintLog(const Query &);
@@ -98,18 +150,25 @@ public:
   SolverRunStatus getOperationStatusCode();
 };
 
-Z3SolverImpl::Z3SolverImpl()
+Z3SolverImpl::Z3SolverImpl(bool incremental, const Z3Configuration &config,
+                           bool logInteraction)
     : builder(new Z3Builder(
           /*autoClearConstructCache=*/false,
-          /*z3LogInteractionFileArg=*/Z3LogInteractionFile.size() > 0
+          /*z3LogInteractionFileArg=*/
+          logInteraction && Z3LogInteractionFile.size() > 0
               ? Z3LogInteractionFile.c_str()
               : NULL)),
-      runStatusCode(SOLVER_RUN_STATUS_FAILURE) {
+      config(config), runStatusCode(SOLVER_RUN_STATUS_FAILURE),
+      incremental(incremental), incrementalSolver(NULL) {
   assert(builder && "unable to create Z3Builder");
   solverParameters = Z3_mk_params(builder->ctx);
   Z3_params_inc_ref(builder->ctx, solverParameters);
   timeoutParamStrSymbol = Z3_mk_string_symbol(builder->ctx, "timeout");
   setCoreSolverTimeout(timeout);
+  if (config.seed)
+    Z3_params_set_uint(builder->ctx, solverParameters,
+                       Z3_mk_string_symbol(builder->ctx, "random_seed"),
+                       config.seed);
 
   if (!Z3QueryDumpFile.empty()) {
     klee_error("Dumping of Z3 queries currently not supported");
@@ -135,11 +194,14 @@ Z3SolverImpl::Z3SolverImpl()
 }
 
 Z3SolverImpl::~Z3SolverImpl() {
+  if (incrementalSolver)
+    Z3_solver_dec_ref(builder->ctx, incrementalSolver);
   Z3_params_dec_ref(builder->ctx, solverParameters);
   delete builder;
 }
 
-Z3Solver::Z3Solver() : Solver(new Z3SolverImpl()) {}
+Z3Solver::Z3Solver(bool incremental)
+    : Solver(new Z3SolverImpl(incremental)) {}
 
 char *Z3Solver::getConstraintLog(const Query &query) {
   return impl->getConstraintLog(query);
@@ -252,39 +314,70 @@ bool Z3SolverImpl::internalRunSolver(
     std::vector<std::vector<unsigned char> > *values, bool &hasSolution) {
 
   TimerStatIncrementer t(stats::queryTime);
+  ++stats::queries;
+  if (objects)
+    ++stats::queryCounterexamples;
+
+  Z3_solver theSolver = prepareSolver(query);
+  ::Z3_lbool satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  return finishSolver(theSolver, satisfiable, objects, values, hasSolution);
+}
+
+::Z3_solver Z3SolverImpl::mkSolver() {
+  if (config.tactic) {
+    Z3_tactic tactic = Z3_mk_tactic(builder->ctx, config.tactic);
+    Z3_tactic_inc_ref(builder->ctx, tactic);
+    Z3_solver theSolver = Z3_mk_solver_from_tactic(builder->ctx, tactic);
+    Z3_tactic_dec_ref(builder->ctx, tactic);
+    return theSolver;
+  }
+
+  if (config.logic)
+    return Z3_mk_solver_for_logic(
+        builder->ctx, Z3_mk_string_symbol(builder->ctx, config.logic));
+  return Z3_mk_solver(builder->ctx);
+}
+
+::Z3_solver Z3SolverImpl::prepareSolver(const Query &query) {
   // NOTE: Z3 will switch to using a slower solver internally if push/pop are
   // used so for now it is likely that creating a new solver each time is the
-  // right way to go until Z3 changes its behaviour.
+  // right way to go until Z3 changes its behaviour. Incremental mode trades
+  // this for not re-asserting constraints shared with the previous query,
+  // which pays off for long paths with many sibling branches.
   //
   // TODO: Investigate using a custom tactic as described in
   // https://github.com/klee/klee/issues/653
-  Z3_solver theSolver = Z3_mk_solver(builder->ctx);
+  Z3_solver theSolver;
+  if (incremental) {
+    if (!incrementalSolver) {
+      incrementalSolver = mkSolver();
+      Z3_solver_inc_ref(builder->ctx, incrementalSolver);
+    }
+    theSolver = incrementalSolver;
+  } else {
+    theSolver = mkSolver();
+  }
   Z3_solver_inc_ref(builder->ctx, theSolver);
   Z3_solver_set_params(builder->ctx, theSolver, solverParameters);
 
   runStatusCode = SOLVER_RUN_STATUS_FAILURE;
 
   ConstantArrayFinder constant_arrays_in_query;
-  for (auto const &constraint : query.constraints) {
-    Z3_solver_assert(builder->ctx, theSolver, builder->construct(constraint));
-    constant_arrays_in_query.visit(constraint);
+  if (incremental) {
+    assertConstraints(theSolver, query.constraints);
+    // Scope for the query expression, popped after the check.
+    Z3_solver_push(builder->ctx, theSolver);
+  } else {
+    for (auto const &constraint : query.constraints) {
+      Z3_solver_assert(builder->ctx, theSolver, builder->construct(constraint));
+      constant_arrays_in_query.visit(constraint);
+    }
   }
-  ++stats::queries;
-  if (objects)
-    ++stats::queryCounterexamples;
 
   Z3ASTHandle z3QueryExpr =
       Z3ASTHandle(builder->construct(query.expr), builder->ctx);
   constant_arrays_in_query.visit(query.expr);
-
-  for (auto const &constant_array : constant_arrays_in_query.results) {
-    assert(builder->constant_array_assertions.count(constant_array) == 1 &&
-           "Constant array found in query, but not handled by Z3Builder");
-    for (auto const &arrayIndexValueExpr :
-         builder->constant_array_assertions[constant_array]) {
-      Z3_solver_assert(builder->ctx, theSolver, arrayIndexValueExpr);
-    }
-  }
+  assertConstantArrays(theSolver, constant_arrays_in_query);
 
   // KLEE Queries are validity queries i.e.
   // ∀ X Constraints(X) → query(X)
@@ -304,17 +397,16 @@ bool Z3SolverImpl::internalRunSolver(
     dumpedQueriesFile->flush();
   }
 
-  ::Z3_lbool satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  return theSolver;
+}
+
+bool Z3SolverImpl::finishSolver(
+    ::Z3_solver theSolver, ::Z3_lbool satisfiable,
+    const std::vector<const Array *> *objects,
+    std::vector<std::vector<unsigned char> > *values, bool &hasSolution) {
   runStatusCode = handleSolverResponse(theSolver, satisfiable, objects, values,
                                        hasSolution);
-
-  Z3_solver_dec_ref(builder->ctx, theSolver);
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
-  // we allow Z3_ast expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
-  // ``builder->construct()``.
-  builder->clearConstructCache();
+  releaseSolver(theSolver);
 
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
@@ -328,6 +420,67 @@ bool Z3SolverImpl::internalRunSolver(
   return false; // failed
 }
 
+void Z3SolverImpl::releaseSolver(::Z3_solver theSolver) {
+  if (incremental)
+    Z3_solver_pop(builder->ctx, theSolver, 1);
+  Z3_solver_dec_ref(builder->ctx, theSolver);
+  // Clear the builder's cache to prevent memory usage exploding.
+  // By using ``autoClearConstructCache=false`` and clearning now
+  // we allow Z3_ast expressions to be shared from an entire
+  // ``Query`` rather than only sharing within a single call to
+  // ``builder->construct()``.
+  builder->clearConstructCache();
+}
+
+void Z3SolverImpl::resetIncrementalSolver() {
+  if (!incrementalSolver)
+    return;
+
+  Z3_solver_dec_ref(builder->ctx, incrementalSolver);
+  incrementalSolver = NULL;
+  assertedConstraints.clear();
+}
+
+void Z3SolverImpl::assertConstraints(::Z3_solver theSolver,
+                                     const ConstraintSet &constraints) {
+  // Keep the longest prefix of constraints shared with the previous query.
+  size_t common = 0;
+  auto it = constraints.begin(), ie = constraints.end();
+  while (it != ie && common < assertedConstraints.size() &&
+         *it == assertedConstraints[common]) {
+    ++it;
+    ++common;
+  }
+
+  if (common < assertedConstraints.size()) {
+    Z3_solver_pop(builder->ctx, theSolver,
+                  assertedConstraints.size() - common);
+    assertedConstraints.resize(common);
+  }
+
+  for (; it != ie; ++it) {
+    ConstantArrayFinder constant_arrays_in_constraint;
+    constant_arrays_in_constraint.visit(*it);
+
+    Z3_solver_push(builder->ctx, theSolver);
+    Z3_solver_assert(builder->ctx, theSolver, builder->construct(*it));
+    assertConstantArrays(theSolver, constant_arrays_in_constraint);
+    assertedConstraints.push_back(*it);
+  }
+}
+
+void Z3SolverImpl::assertConstantArrays(::Z3_solver theSolver,
+                                        ConstantArrayFinder &finder) {
+  for (auto const &constant_array : finder.results) {
+    assert(builder->constant_array_assertions.count(constant_array) == 1 &&
+           "Constant array found in query, but not handled by Z3Builder");
+    for (auto const &arrayIndexValueExpr :
+         builder->constant_array_assertions[constant_array]) {
+      Z3_solver_assert(builder->ctx, theSolver, arrayIndexValueExpr);
+    }
+  }
+}
+
 SolverImpl::SolverRunStatus Z3SolverImpl::handleSolverResponse(
     ::Z3_solver theSolver, ::Z3_lbool satisfiable,
     const std::vector<const Array *> *objects,
@@ -463,5 +616,199 @@ bool Z3SolverImpl::validateZ3Model(::Z3_solver &theSolver, ::Z3_model &theModel)
 SolverImpl::SolverRunStatus Z3SolverImpl::getOperationStatusCode() {
   return runStatusCode;
 }
+
+/// Z3PortfolioSolverImpl - Runs each query on several differently configured
+/// Z3SolverImpl instances. Since neither Z3 contexts nor KLEE expressions may
+/// be shared between threads, Z3 expressions are constructed for all
+/// instances by the calling thread and only Z3_solver_check() is performed
+/// in parallel, each instance in its own thread.
+class Z3PortfolioSolverImpl : public SolverImpl {
+private:
+  std::vector<std::unique_ptr<Z3SolverImpl> > members;
+  SolverRunStatus runStatusCode;
+
+  size_t check(const std::vector<::Z3_solver> &solvers,
+               std::vector<::Z3_lbool> &results);
+  bool internalRunSolver(const Query &,
+                         const std::vector<const Array *> *objects,
+                         std::vector<std::vector<unsigned char> > *values,
+                         bool &hasSolution);
+
+public:
+  Z3PortfolioSolverImpl(unsigned size, bool incremental);
+
+  char *getConstraintLog(const Query &query) {
+    return members.front()->getConstraintLog(query);
+  }
+  void setCoreSolverTimeout(time::Span timeout) {
+    for (auto &member : members)
+      member->setCoreSolverTimeout(timeout);
+  }
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool computeInitialValues(const Query &,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode() { return runStatusCode; }
+};
+
+Z3PortfolioSolverImpl::Z3PortfolioSolverImpl(unsigned size, bool incremental)
+    : runStatusCode(SOLVER_RUN_STATUS_FAILURE) {
+  size_t max = sizeof(portfolioConfigurations) / sizeof(*portfolioConfigurations);
+  if (size < 1 || size > max) {
+    klee_warning("Z3 portfolio size must be between 1 and %zu, using %zu",
+                 max, max);
+    size = max;
+  }
+
+  // Z3 only supports a single interaction log, see Z3Builder.
+  for (unsigned i = 0; i < size; i++)
+    members.emplace_back(new Z3SolverImpl(
+        incremental, portfolioConfigurations[i], /*logInteraction=*/i == 0));
+}
+
+bool Z3PortfolioSolverImpl::computeTruth(const Query &query, bool &isValid) {
+  bool hasSolution = false; // to remove compiler warning
+  bool status =
+      internalRunSolver(query, /*objects=*/NULL, /*values=*/NULL, hasSolution);
+  isValid = !hasSolution;
+  return status;
+}
+
+bool Z3PortfolioSolverImpl::computeValue(const Query &query,
+                                         ref<Expr> &result) {
+  std::vector<const Array *> objects;
+  std::vector<std::vector<unsigned char> > values;
+  bool hasSolution;
+
+  // Find the object used in the expression, and compute an assignment
+  // for them.
+  findSymbolicObjects(query.expr, objects);
+  if (!computeInitialValues(query.withFalse(), objects, values, hasSolution))
+    return false;
+  assert(hasSolution && "state has invalid constraint set");
+
+  // Evaluate the expression with the computed assignment.
+  Assignment a(objects, values);
+  result = a.evaluate(query.expr);
+
+  return true;
+}
+
+bool Z3PortfolioSolverImpl::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<std::vector<unsigned char> > &values, bool &hasSolution) {
+  return internalRunSolver(query, &objects, &values, hasSolution);
+}
+
+bool Z3PortfolioSolverImpl::internalRunSolver(
+    const Query &query, const std::vector<const Array *> *objects,
+    std::vector<std::vector<unsigned char> > *values, bool &hasSolution) {
+
+  TimerStatIncrementer t(stats::queryTime);
+  ++stats::queries;
+  if (objects)
+    ++stats::queryCounterexamples;
+
+  std::vector<::Z3_solver> solvers;
+  for (auto &member : members)
+    solvers.push_back(member->prepareSolver(query));
+
+  std::vector<::Z3_lbool> results(members.size(), Z3_L_UNDEF);
+  size_t winner = check(solvers, results);
+
+  for (size_t i = 0; i < members.size(); i++) {
+    if (i != winner)
+      members[i]->releaseSolver(solvers[i]);
+  }
+
+  bool success = members[winner]->finishSolver(
+      solvers[winner], results[winner], objects, values, hasSolution);
+  runStatusCode = members[winner]->getOperationStatusCode();
+  return success;
+}
+
+/// Check all solvers in parallel, returns the index of the first solver which
+/// found the query to be satisfiable or unsatisfiable. The remaining solvers
+/// are interrupted. If no solver succeeded, the first one is returned.
+size_t Z3PortfolioSolverImpl::check(const std::vector<::Z3_solver> &solvers,
+                                    std::vector<::Z3_lbool> &results) {
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::vector<bool> finished(members.size(), false);
+  std::vector<bool> interrupted(members.size(), false);
+  size_t pending = members.size();
+  size_t winner = members.size();
+
+  auto run = [&](size_t i) {
+    ::Z3_lbool result = Z3_solver_check(members[i]->builder->ctx, solvers[i]);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    results[i] = result;
+    finished[i] = true;
+    if (winner == members.size() && result != Z3_L_UNDEF)
+      winner = i;
+    pending--;
+    cond.notify_all();
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < members.size(); i++)
+    threads.emplace_back(run, i);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (pending > 0) {
+    if (winner == members.size()) {
+      cond.wait(lock);
+      continue;
+    }
+
+    // An interrupt only takes effect while Z3_solver_check() is running,
+    // repeat it for threads which have not entered it yet.
+    for (size_t i = 0; i < members.size(); i++) {
+      if (!finished[i]) {
+        Z3_interrupt(members[i]->builder->ctx);
+        interrupted[i] = true;
+      }
+    }
+    cond.wait_for(lock, std::chrono::milliseconds(1));
+  }
+  lock.unlock();
+
+  for (auto &thread : threads)
+    thread.join();
+
+  // An interrupt may also hit a context right after its check returned.
+  // The context then remains canceled, i.e. subsequent operations such as
+  // Z3_solver_push() fail, until the next check. Checking an empty solver
+  // resets this state. Incremental solvers are not reused after being
+  // interrupted, their state may be inconsistent afterwards.
+  for (size_t i = 0; i < members.size(); i++) {
+    if (!interrupted[i])
+      continue;
+    members[i]->resetIncrementalSolver();
+
+    Z3_context ctx = members[i]->builder->ctx;
+    Z3_solver empty = Z3_mk_simple_solver(ctx);
+    Z3_solver_inc_ref(ctx, empty);
+    Z3_solver_check(ctx, empty);
+    Z3_solver_dec_ref(ctx, empty);
+  }
+
+  return (winner == members.size()) ? 0 : winner;
+}
+
+Z3PortfolioSolver::Z3PortfolioSolver(unsigned size, bool incremental)
+    : Solver(new Z3PortfolioSolverImpl(size, incremental)) {}
+
+char *Z3PortfolioSolver::getConstraintLog(const Query &query) {
+  return impl->getConstraintLog(query);
+}
+
+void Z3PortfolioSolver::setCoreSolverTimeout(time::Span timeout) {
+  impl->setCoreSolverTimeout(timeout);
+}
 }
 #endif // ENABLE_Z3
@@ -18,7 +18,11 @@ namespace klee {
 class Z3Solver : public Solver {
 public:
   /// Z3Solver - Construct a new Z3Solver.
-  Z3Solver();
+  ///
+  /// \param incremental - Keep a single Z3 solver instance alive across
+  /// queries and only assert the constraints which differ from the
+  /// previous query (see Z3SolverImpl::assertConstraints).
+  Z3Solver(bool incremental = false);
 
   /// Get the query in SMT-LIBv2 format.
   /// \return A C-style string. The caller is responsible for freeing this.
@@ -29,6 +33,21 @@ public:
   /// is off.
   virtual void setCoreSolverTimeout(time::Span timeout);
 };
+
+/// Z3PortfolioSolver - A complete solver running several differently
+/// configured Z3 instances (logics, tactics, random seeds) in parallel
+/// threads. The first answer is used, the other instances are interrupted.
+class Z3PortfolioSolver : public Solver {
+public:
+  /// Z3PortfolioSolver - Construct a new Z3PortfolioSolver.
+  ///
+  /// \param size - Number of Z3 instances, i.e. threads, per query.
+  /// \param incremental - See Z3Solver::Z3Solver.
+  Z3PortfolioSolver(unsigned size, bool incremental = false);
+
+  virtual char *getConstraintLog(const Query &);
+  virtual void setCoreSolverTimeout(time::Span timeout);
+};
 }
 
 #endif /* KLEE_Z3SOLVER_H */
@@ -1,8 +1,68 @@
+#include <string.h>
+
+#include <algorithm>
 #include <iostream>
 
 #include <clover/clover.h>
 using namespace clover;
 
+#define PAGE_NUM(ADDR) ((ADDR) >> ConcolicMemory::PAGE_BITS)
+#define PAGE_OFF(ADDR) ((ADDR) & (ConcolicMemory::PAGE_SIZE - 1))
+
+bool
+ConcolicMemory::Page::isInitialized(size_t off, size_t len)
+{
+	if (complete)
+		return true;
+
+	for (size_t i = 0; i < len; i++) {
+		if (!initialized[off + i])
+			return false;
+	}
+
+	return true;
+}
+
+void
+ConcolicMemory::Page::setInitialized(size_t off, size_t len)
+{
+	if (complete)
+		return;
+
+	for (size_t i = 0; i < len; i++)
+		initialized[off + i] = true;
+	complete = initialized.all();
+}
+
+void
+ConcolicMemory::Page::setSymbolic(size_t off, Ref<ConcolicValue> byte)
+{
+	if (!shadow)
+		shadow = std::make_unique<Shadow>();
+
+	if (!shadow->bytes[off])
+		shadow->count++;
+	shadow->bytes[off] = byte;
+}
+
+void
+ConcolicMemory::Page::clearSymbolic(size_t off, size_t len)
+{
+	if (!shadow)
+		return;
+
+	for (size_t i = 0; i < len; i++) {
+		if (shadow->bytes[off + i]) {
+			shadow->bytes[off + i] = nullptr;
+			shadow->count--;
+		}
+	}
+
+	// Page is fully concrete again.
+	if (shadow->count == 0)
+		shadow.reset();
+}
+
 ConcolicMemory::ConcolicMemory(Solver &_solver)
     : solver(_solver)
 {
@@ -12,24 +72,100 @@ ConcolicMemory::ConcolicMemory(Solver &_solver)
 void
 ConcolicMemory::reset(void)
 {
-	data.clear();
+	for (auto &it : pages)
+		revokeDirect(it.first, it.second.get());
+
+	pages.clear();
+	lastPage = nullptr;
+}
+
+ConcolicMemory::Page *
+ConcolicMemory::getPage(Addr addr, bool create)
+{
+	Addr num = PAGE_NUM(addr);
+	if (lastPage && lastPageNum == num)
+		return lastPage;
+
+	auto it = pages.find(num);
+	if (it == pages.end()) {
+		if (!create)
+			return nullptr;
+		it = pages.emplace(num, std::make_unique<Page>()).first;
+	}
+
+	lastPageNum = num;
+	lastPage = it->second.get();
+	return lastPage;
+}
+
+void
+ConcolicMemory::revokeDirect(Addr num, Page *page)
+{
+	if (!page->direct)
+		return;
+
+	page->direct = false;
+	if (invalidate)
+		invalidate(num << PAGE_BITS, PAGE_SIZE);
+}
+
+void
+ConcolicMemory::warnUninitialized(Addr addr)
+{
+	std::cerr << "WARNING: Uninitialized memory accessed at 0x"
+	          << std::hex << addr << " initializing with zero" << std::endl;
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
+ConcolicMemory::loadByte(Addr addr)
+{
+	Page *page = getPage(addr, false);
+	size_t off = PAGE_OFF(addr);
+
+	if (!page || !page->isInitialized(off, 1))
+		warnUninitialized(addr);
+	if (!page)
+		return solver.BVC(ConcreteValue(0, klee::Expr::Int8));
+
+	if (page->shadow && page->shadow->bytes[off])
+		return page->shadow->bytes[off];
+	return solver.BVC(ConcreteValue(page->data[off], klee::Expr::Int8));
+}
+
+void
+ConcolicMemory::storeByte(Addr addr, Ref<ConcolicValue> byte)
+{
+	Page *page = getPage(addr, true);
+	size_t off = PAGE_OFF(addr);
+
+	page->data[off] = solver.getValue<uint8_t>(byte->concrete);
+	page->setInitialized(off, 1);
+
+	if (byte->symbolic.has_value()) {
+		revokeDirect(PAGE_NUM(addr), page);
+		page->setSymbolic(off, byte);
+	} else {
+		page->clearSymbolic(off, 1);
+	}
+}
+
+Ref<ConcolicValue>
 ConcolicMemory::load(Addr addr, unsigned bytesize)
 {
-	std::shared_ptr<ConcolicValue> result = nullptr;
-	for (uint32_t off = 0; off < bytesize; off++) {
-		auto read_addr = addr + off;
+	// Fast path: value within a single, fully concrete page.
+	Page *page = getPage(addr, false);
+	size_t start = PAGE_OFF(addr);
+	if (page && !page->shadow && bytesize <= sizeof(uint64_t) &&
+	    start + bytesize <= PAGE_SIZE && page->isInitialized(start, bytesize)) {
+		uint64_t value = 0;
+		for (unsigned i = 0; i < bytesize; i++)
+			value |= (uint64_t)page->data[start + i] << (i * 8);
+		return solver.BVC(ConcreteValue(value, bytesize * 8));
+	}
 
-		std::shared_ptr<ConcolicValue> byte;
-		if (data.count(read_addr)) {
-			byte = data.at(read_addr);
-		} else {
-			std::cerr << "WARNING: Uninitialized memory accessed at 0x"
-			          << std::hex << read_addr << " initializing with zero" << std::endl;
-			byte = solver.BVC(std::nullopt, (uint8_t)0);
-		}
+	Ref<ConcolicValue> result = nullptr;
+	for (uint32_t off = 0; off < bytesize; off++) {
+		auto byte = loadByte(addr + off);
 
 		if (!result) {
 			result = byte;
@@ -41,28 +177,123 @@ ConcolicMemory::load(Addr addr, unsigned bytesize)
 	return result;
 }
 
-std::shared_ptr<ConcolicValue>
-ConcolicMemory::load(std::shared_ptr<ConcolicValue> addr, unsigned bytesize)
+Ref<ConcolicValue>
+ConcolicMemory::load(Ref<ConcolicValue> addr, unsigned bytesize)
 {
 	auto base_addr = solver.getValue<ConcolicMemory::Addr>(addr->concrete);
 	return load(base_addr, bytesize);
 }
 
 void
-ConcolicMemory::store(Addr addr, std::shared_ptr<ConcolicValue> value, unsigned bytesize)
+ConcolicMemory::store(Addr addr, Ref<ConcolicValue> value, unsigned bytesize)
 {
+	// Fast path: concrete value, stored as plain bytes.
+	if (!value->symbolic.has_value() && value->concrete.isInline() && bytesize <= sizeof(uint64_t)) {
+		uint8_t buf[sizeof(uint64_t)];
+		uint64_t v = value->concrete.getZExtValue();
+		for (unsigned i = 0; i < bytesize; i++)
+			buf[i] = (uint8_t)(v >> (i * 8));
+
+		storeConcrete(addr, buf, bytesize);
+		return;
+	}
+
 	if (value->getWidth() < bytesize * 8)
 		value = value->zext(bytesize * 8);
 
 	for (size_t off = 0; off < bytesize; off++) {
 		// Extract expression works on bit indicies, not bytes.
-		data[addr + off] = value->extract(off * 8, klee::Expr::Int8);
+		storeByte(addr + off, value->extract(off * 8, klee::Expr::Int8));
 	}
 }
 
 void
-ConcolicMemory::store(std::shared_ptr<ConcolicValue> addr, std::shared_ptr<ConcolicValue> value, unsigned bytesize)
+ConcolicMemory::store(Ref<ConcolicValue> addr, Ref<ConcolicValue> value, unsigned bytesize)
 {
 	auto base_addr = solver.getValue<ConcolicMemory::Addr>(addr->concrete);
 	return store(base_addr, value, bytesize);
 }
+
+void
+ConcolicMemory::loadConcrete(Addr addr, uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		Page *page = getPage(addr, false);
+		size_t off = PAGE_OFF(addr);
+		size_t n = std::min(len, PAGE_SIZE - off);
+
+		if (page)
+			memcpy(buf, &page->data[off], n);
+		else
+			memset(buf, 0, n);
+
+		addr += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+void
+ConcolicMemory::storeConcrete(Addr addr, const uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		Page *page = getPage(addr, true);
+		size_t off = PAGE_OFF(addr);
+		size_t n = std::min(len, PAGE_SIZE - off);
+
+		memcpy(&page->data[off], buf, n);
+		page->setInitialized(off, n);
+		page->clearSymbolic(off, n);
+
+		addr += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+bool
+ConcolicMemory::isConcrete(Addr addr, size_t len)
+{
+	while (len > 0) {
+		Page *page = getPage(addr, false);
+		size_t off = PAGE_OFF(addr);
+		size_t n = std::min(len, PAGE_SIZE - off);
+
+		if (page && page->shadow) {
+			for (size_t i = 0; i < n; i++) {
+				if (page->shadow->bytes[off + i])
+					return false;
+			}
+		}
+
+		addr += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+bool
+ConcolicMemory::isConcretePage(Addr addr)
+{
+	Page *page = getPage(addr, false);
+	return !page || !page->shadow;
+}
+
+uint8_t *
+ConcolicMemory::getDirectPage(Addr addr)
+{
+	Page *page = getPage(addr, true);
+	if (page->shadow)
+		return nullptr;
+
+	page->complete = true;
+	page->direct = true;
+	return page->data;
+}
+
+void
+ConcolicMemory::setInvalidate(InvalidateHandler handler)
+{
+	invalidate = handler;
+}
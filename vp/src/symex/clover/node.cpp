@@ -1,6 +1,8 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include <algorithm>
+
 #include <clover/clover.h>
 
 using namespace clover;
@@ -8,12 +10,16 @@ using namespace clover;
 #define CHECK_BRANCH(BRANCH, ...) \
 	(BRANCH && BRANCH->randomUnnegated(__VA_ARGS__))
 
-Trace::Node::Node(void)
+Trace::Node::Node(Node *_parent, unsigned _generation)
 {
 	value = nullptr;
 
 	true_branch = nullptr;
 	false_branch = nullptr;
+
+	parent = _parent;
+	depth = (parent) ? parent->depth + 1 : 0;
+	generation = _generation;
 }
 
 bool
@@ -22,6 +28,44 @@ Trace::Node::isPlaceholder(void)
 	return this->value == nullptr;
 }
 
+bool
+Trace::Node::isCandidate(void)
+{
+	if (isPlaceholder() || value->wasNegated)
+		return false;
+
+	return (true_branch == nullptr) != (false_branch == nullptr);
+}
+
+SearchStrategy::Candidate
+Trace::Node::toCandidate(void)
+{
+	SearchStrategy::Candidate c;
+
+	assert(!isPlaceholder());
+	c.addr = value->addr;
+	c.condition = (true_branch == nullptr);
+	c.depth = depth;
+	c.generation = generation;
+
+	return c;
+}
+
+Trace::Path
+Trace::Node::getPath(void)
+{
+	Path path;
+
+	// The last element refers to the explored direction, it
+	// is negated by Trace::newQuery() to obtain a new path.
+	path.push_back(std::make_pair(value, true_branch != nullptr));
+	for (Node *n = this; n->parent; n = n->parent)
+		path.push_back(std::make_pair(n->parent->value, n->parent->true_branch == n));
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
 bool
 Trace::Node::randomUnnegated(Path &path)
 {
@@ -33,7 +77,7 @@ Trace::Node::randomUnnegated(Path &path)
 	size_t idx = path.size() - 1;
 
 	/* This prefers node in the upper tree */
-	if (!value->wasNegated && (!true_branch || !false_branch)) {
+	if (!value->wasNegated && !value->deferred && (!true_branch || !false_branch)) {
 		path[idx].second = (true_branch != nullptr);
 		if (path[idx].second)
 			assert(false_branch == nullptr);
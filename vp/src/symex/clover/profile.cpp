@@ -0,0 +1,295 @@
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <unordered_set>
+
+#include <clover/clover.h>
+
+#include <klee/Expr/ExprUtil.h>
+#include <klee/Solver/SolverImpl.h>
+#include <klee/Statistics/Statistics.h>
+
+using namespace clover;
+
+// Number of slowest queries retained in the profile.
+#define TOP_QUERIES 10
+
+static size_t
+bucket(size_t value)
+{
+	size_t i = 0;
+	while (value && i + 1 < std::tuple_size<SolverProfile::Histogram>::value) {
+		value >>= 1;
+		i++;
+	}
+	return i;
+}
+
+static size_t
+countNodes(const klee::Query &query)
+{
+	std::unordered_set<const klee::Expr *> visited;
+	std::vector<klee::ref<klee::Expr>> stack(query.constraints.begin(), query.constraints.end());
+
+	// Expressions are DAGs, shared subexpressions are only counted once.
+	stack.push_back(query.expr);
+	while (!stack.empty()) {
+		auto expr = stack.back();
+		stack.pop_back();
+		if (!visited.insert(expr.get()).second)
+			continue;
+
+		for (unsigned i = 0; i < expr->getNumKids(); i++)
+			stack.push_back(expr->getKid(i));
+
+		// Indices and values of array updates are no kids.
+		if (auto re = dyn_cast<klee::ReadExpr>(expr)) {
+			for (auto un = re->updates.head; !un.isNull(); un = un->next) {
+				stack.push_back(un->index);
+				stack.push_back(un->value);
+			}
+		}
+	}
+
+	return visited.size();
+}
+
+/* Solver layer recording queries passing through the wrapped layer. */
+class ProfileSolverImpl : public klee::SolverImpl {
+private:
+	klee::Solver *solver;
+	SolverProfile &profile;
+	size_t layer;
+
+	template <typename F>
+	bool
+	measure(const klee::Query &query, F fn)
+	{
+		if (!profile.isEnabled())
+			return fn();
+
+		profile.enter(layer, query);
+		auto start = std::chrono::steady_clock::now();
+		bool ret = fn();
+		auto end = std::chrono::steady_clock::now();
+		profile.leave(layer, std::chrono::duration<double, std::milli>(end - start).count());
+
+		return ret;
+	}
+
+public:
+	ProfileSolverImpl(klee::Solver *_solver, SolverProfile &_profile, size_t _layer)
+	    : solver(_solver), profile(_profile), layer(_layer)
+	{
+		return;
+	}
+
+	~ProfileSolverImpl(void)
+	{
+		delete solver;
+	}
+
+	bool computeValidity(const klee::Query &query, klee::Solver::Validity &result)
+	{
+		return measure(query, [&]() { return solver->impl->computeValidity(query, result); });
+	}
+
+	bool computeTruth(const klee::Query &query, bool &isValid)
+	{
+		return measure(query, [&]() { return solver->impl->computeTruth(query, isValid); });
+	}
+
+	bool computeValue(const klee::Query &query, klee::ref<klee::Expr> &result)
+	{
+		return measure(query, [&]() { return solver->impl->computeValue(query, result); });
+	}
+
+	bool computeInitialValues(const klee::Query &query,
+	                          const std::vector<const klee::Array *> &objects,
+	                          std::vector<std::vector<unsigned char>> &values,
+	                          bool &hasSolution)
+	{
+		return measure(query, [&]() {
+			return solver->impl->computeInitialValues(query, objects, values, hasSolution);
+		});
+	}
+
+	SolverRunStatus getOperationStatusCode(void)
+	{
+		return solver->impl->getOperationStatusCode();
+	}
+
+	char *getConstraintLog(const klee::Query &query)
+	{
+		return solver->impl->getConstraintLog(query);
+	}
+
+	void setCoreSolverTimeout(klee::time::Span timeout)
+	{
+		solver->impl->setCoreSolverTimeout(timeout);
+	}
+};
+
+void
+SolverProfile::enable(void)
+{
+	enabled = true;
+}
+
+bool
+SolverProfile::isEnabled(void)
+{
+	return enabled;
+}
+
+void
+SolverProfile::setOrigin(uint32_t pc)
+{
+	origin = pc;
+}
+
+klee::Solver *
+SolverProfile::wrap(std::string name, klee::Solver *solver)
+{
+	size_t layer = layers.size();
+	layers.push_back(Layer{name});
+
+	return new klee::Solver(new ProfileSolverImpl(solver, *this, layer));
+}
+
+void
+SolverProfile::enter(size_t layer, const klee::Query &query)
+{
+	layers.at(layer).queries++;
+	if (depth++ > 0) {
+		current.layer = std::min(current.layer, layer);
+		return;
+	}
+
+	std::vector<const klee::Array *> objects;
+	klee::findSymbolicObjects(query.expr, objects);
+	for (auto e : query.constraints)
+		klee::findSymbolicObjects(e, objects);
+	std::sort(objects.begin(), objects.end());
+	objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+
+	current.pc = origin;
+	current.time = 0;
+	current.constraints = query.constraints.size();
+	current.nodes = countNodes(query);
+	current.arrays = objects.size();
+	current.layer = layer;
+}
+
+void
+SolverProfile::leave(size_t layer, double time)
+{
+	layers.at(layer).time += time;
+	if (--depth > 0)
+		return;
+
+	current.time = time;
+	queries++;
+	constraints[bucket(current.constraints)]++;
+	nodes[bucket(current.nodes)]++;
+	arrays[bucket(current.arrays)]++;
+
+	// The origin only applies to a single query.
+	origin = 0;
+
+	auto slower = [](const QueryInfo &a, const QueryInfo &b) {
+		return a.time > b.time;
+	};
+	if (slowest.size() < TOP_QUERIES || current.time > slowest.back().time) {
+		slowest.insert(std::upper_bound(slowest.begin(), slowest.end(), current, slower), current);
+		if (slowest.size() > TOP_QUERIES)
+			slowest.pop_back();
+	}
+}
+
+static void
+writeHistogram(std::ostream &stream, const SolverProfile::Histogram &histogram)
+{
+	bool first = true;
+
+	// Only non-empty buckets are included, bounds are inclusive.
+	stream << "[";
+	for (size_t i = 0; i < histogram.size(); i++) {
+		if (!histogram[i])
+			continue;
+
+		uint64_t lower = (i) ? UINT64_C(1) << (i - 1) : 0;
+		uint64_t upper = (i) ? (UINT64_C(1) << i) - 1 : 0;
+		stream << ((first) ? "" : ", ") << "{\"min\": " << lower
+		       << ", \"max\": " << upper << ", \"count\": " << histogram[i] << "}";
+		first = false;
+	}
+	stream << "]";
+}
+
+void
+SolverProfile::write(std::ostream &stream)
+{
+	stream << std::fixed << std::setprecision(3);
+	stream << "{" << std::endl;
+	stream << "  \"queries\": " << queries << "," << std::endl;
+
+	// Layers are reported in the order queries pass through them.
+	stream << "  \"layers\": [" << std::endl;
+	for (size_t i = layers.size(); i-- > 0;) {
+		auto &layer = layers[i];
+		uint64_t forwarded = (i > 0) ? layers[i - 1].queries : 0;
+		double inner = (i > 0) ? layers[i - 1].time : 0;
+
+		// Layers may split queries (e.g. into independent constraint
+		// sets), in which case more queries are forwarded than received.
+		uint64_t answered = (forwarded < layer.queries) ? layer.queries - forwarded : 0;
+		double rate = (layer.queries) ? (double)answered / layer.queries : 0;
+
+		stream << "    {\"name\": \"" << layer.name << "\", "
+		       << "\"queries\": " << layer.queries << ", "
+		       << "\"forwarded\": " << forwarded << ", "
+		       << "\"answered\": " << answered << ", "
+		       << "\"hit_rate\": " << rate << ", "
+		       << "\"time_ms\": " << layer.time << ", "
+		       << "\"self_time_ms\": " << std::max(layer.time - inner, 0.0) << "}"
+		       << ((i > 0) ? "," : "") << std::endl;
+	}
+	stream << "  ]," << std::endl;
+
+	stream << "  \"histograms\": {" << std::endl;
+	stream << "    \"constraints\": ";
+	writeHistogram(stream, constraints);
+	stream << "," << std::endl << "    \"nodes\": ";
+	writeHistogram(stream, nodes);
+	stream << "," << std::endl << "    \"arrays\": ";
+	writeHistogram(stream, arrays);
+	stream << std::endl << "  }," << std::endl;
+
+	stream << "  \"slowest\": [" << std::endl;
+	for (size_t i = 0; i < slowest.size(); i++) {
+		auto &query = slowest[i];
+		stream << "    {\"pc\": \"0x" << std::hex << query.pc << std::dec << "\", "
+		       << "\"time_ms\": " << query.time << ", "
+		       << "\"constraints\": " << query.constraints << ", "
+		       << "\"nodes\": " << query.nodes << ", "
+		       << "\"arrays\": " << query.arrays << ", "
+		       << "\"answered_by\": \"" << layers.at(query.layer).name << "\"}"
+		       << ((i + 1 < slowest.size()) ? "," : "") << std::endl;
+	}
+	stream << "  ]," << std::endl;
+
+	// Counters maintained by the KLEE solver layers themselves.
+	auto manager = klee::theStatisticManager;
+	unsigned count = (manager) ? manager->getNumStatistics() : 0;
+	stream << "  \"klee_stats\": {" << std::endl;
+	for (unsigned i = 0; i < count; i++) {
+		auto &stat = manager->getStatistic(i);
+		stream << "    \"" << stat.getName() << "\": " << stat.getValue()
+		       << ((i + 1 < count) ? "," : "") << std::endl;
+	}
+	stream << "  }" << std::endl;
+	stream << "}" << std::endl;
+}
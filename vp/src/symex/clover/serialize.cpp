@@ -0,0 +1,393 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+/* Each serialized expression consists of a sequence of records. Each
+ * record defines a new array, update node, or expression. Records are
+ * identified by their index in the table for the given record type.
+ * The sequence is terminated by an end record which references the
+ * expression in the table that was serialized. Subexpressions which
+ * were already serialized by the same ExprWriter are not serialized
+ * again, instead they are referenced through their table index. */
+
+enum RecordType : uint8_t {
+	RECORD_ARRAY = 'A',
+	RECORD_UPDATE = 'U',
+	RECORD_EXPR = 'E',
+	RECORD_END = '.',
+};
+
+#define NO_INDEX UINT32_MAX
+
+template <typename T>
+static void
+writeInt(std::ostream &stream, T value)
+{
+	stream.write((char *)&value, sizeof(value));
+}
+
+template <typename T>
+static T
+readInt(std::istream &stream)
+{
+	T value;
+
+	if (!stream.read((char *)&value, sizeof(value)))
+		throw std::runtime_error("unexpected end of serialized expression");
+	return value;
+}
+
+ExprWriter::ExprWriter(bool _anonymous)
+    : anonymous(_anonymous)
+{
+	return;
+}
+
+uint32_t
+ExprWriter::writeArray(std::ostream &stream, const klee::Array *array)
+{
+	auto it = arrays.find(array);
+	if (it != arrays.end())
+		return it->second;
+
+	// Concrete arrays are presently never created by clover.
+	assert(array->isSymbolicArray());
+
+	std::string name = (anonymous) ? "" : array->getName();
+	writeInt<uint8_t>(stream, RECORD_ARRAY);
+	writeInt<uint32_t>(stream, name.size());
+	stream.write(name.data(), name.size());
+	writeInt<uint64_t>(stream, array->getSize());
+
+	uint32_t idx = arrays.size();
+	arrays[array] = idx;
+	return idx;
+}
+
+uint32_t
+ExprWriter::writeUpdate(std::ostream &stream, const klee::ref<klee::UpdateNode> &un)
+{
+	if (un.isNull())
+		return NO_INDEX;
+
+	auto it = updates.find(un.get());
+	if (it != updates.end())
+		return it->second.first;
+
+	auto next = writeUpdate(stream, un->next);
+	auto index = writeExpr(stream, un->index);
+	auto value = writeExpr(stream, un->value);
+
+	writeInt<uint8_t>(stream, RECORD_UPDATE);
+	writeInt<uint32_t>(stream, next);
+	writeInt<uint32_t>(stream, index);
+	writeInt<uint32_t>(stream, value);
+
+	uint32_t idx = updates.size();
+	updates[un.get()] = std::make_pair(idx, un);
+	return idx;
+}
+
+uint32_t
+ExprWriter::writeExpr(std::ostream &stream, const klee::ref<klee::Expr> &expr)
+{
+	auto it = exprs.find(expr.get());
+	if (it != exprs.end())
+		return it->second.first;
+
+	// Serialize all operands before the expression itself.
+	std::vector<uint32_t> kids;
+	uint32_t array = NO_INDEX, head = NO_INDEX;
+	if (auto re = dyn_cast<klee::ReadExpr>(expr)) {
+		array = writeArray(stream, re->updates.root);
+		head = writeUpdate(stream, re->updates.head);
+	}
+	for (unsigned i = 0; i < expr->getNumKids(); i++)
+		kids.push_back(writeExpr(stream, expr->getKid(i)));
+
+	writeInt<uint8_t>(stream, RECORD_EXPR);
+	writeInt<uint8_t>(stream, expr->getKind());
+	writeInt<uint32_t>(stream, expr->getWidth());
+
+	switch (expr->getKind()) {
+	case klee::Expr::Constant: {
+		auto &value = cast<klee::ConstantExpr>(expr)->getAPValue();
+		writeInt<uint32_t>(stream, value.getNumWords());
+		for (unsigned i = 0; i < value.getNumWords(); i++)
+			writeInt<uint64_t>(stream, value.getRawData()[i]);
+		break;
+	}
+	case klee::Expr::Read:
+		writeInt<uint32_t>(stream, array);
+		writeInt<uint32_t>(stream, head);
+		break;
+	case klee::Expr::Extract:
+		writeInt<uint32_t>(stream, cast<klee::ExtractExpr>(expr)->offset);
+		break;
+	default:
+		break;
+	}
+
+	for (auto kid : kids)
+		writeInt<uint32_t>(stream, kid);
+
+	uint32_t idx = exprs.size();
+	exprs[expr.get()] = std::make_pair(idx, expr);
+	return idx;
+}
+
+void
+ExprWriter::write(std::ostream &stream, Ref<BitVector> bv)
+{
+	auto idx = writeExpr(stream, bv->expr);
+
+	writeInt<uint8_t>(stream, RECORD_END);
+	writeInt<uint32_t>(stream, idx);
+}
+
+ExprReader::ExprReader(Solver &_solver)
+    : solver(_solver)
+{
+	return;
+}
+
+klee::ref<klee::Expr>
+ExprReader::getExpr(uint32_t idx)
+{
+	if (idx >= exprs.size())
+		throw std::out_of_range("invalid expression reference");
+	return exprs.at(idx);
+}
+
+klee::ref<klee::UpdateNode>
+ExprReader::getUpdate(uint32_t idx)
+{
+	if (idx == NO_INDEX)
+		return klee::ref<klee::UpdateNode>();
+	if (idx >= updates.size())
+		throw std::out_of_range("invalid update node reference");
+	return updates.at(idx);
+}
+
+void
+ExprReader::readArray(std::istream &stream)
+{
+	auto len = readInt<uint32_t>(stream);
+	std::string name(len, '\0');
+	if (!stream.read(name.data(), len))
+		throw std::runtime_error("unexpected end of serialized expression");
+	auto size = readInt<uint64_t>(stream);
+
+	// The ArrayCache ensures that arrays with the same name and
+	// size are represented by the same klee::Array instance.
+	arrays.push_back(solver.array_cache.CreateArray(name, size));
+}
+
+void
+ExprReader::readUpdate(std::istream &stream)
+{
+	auto next = getUpdate(readInt<uint32_t>(stream));
+	auto index = getExpr(readInt<uint32_t>(stream));
+	auto value = getExpr(readInt<uint32_t>(stream));
+
+	updates.push_back(new klee::UpdateNode(next, index, value));
+}
+
+void
+ExprReader::readExpr(std::istream &stream)
+{
+	klee::ref<klee::Expr> expr;
+
+	auto kind = (klee::Expr::Kind)readInt<uint8_t>(stream);
+	auto width = readInt<uint32_t>(stream);
+
+	switch (kind) {
+	case klee::Expr::Constant: {
+		std::vector<uint64_t> words(readInt<uint32_t>(stream));
+		for (size_t i = 0; i < words.size(); i++)
+			words[i] = readInt<uint64_t>(stream);
+		expr = klee::ConstantExpr::alloc(llvm::APInt(width, words));
+		break;
+	}
+	case klee::Expr::Read: {
+		auto array = readInt<uint32_t>(stream);
+		if (array >= arrays.size())
+			throw std::out_of_range("invalid array reference");
+
+		auto head = getUpdate(readInt<uint32_t>(stream));
+		auto index = getExpr(readInt<uint32_t>(stream));
+		expr = klee::ReadExpr::alloc(klee::UpdateList(arrays.at(array), head), index);
+		break;
+	}
+	case klee::Expr::Extract: {
+		auto offset = readInt<uint32_t>(stream);
+		auto kid = getExpr(readInt<uint32_t>(stream));
+		expr = klee::ExtractExpr::alloc(kid, offset, width);
+		break;
+	}
+	case klee::Expr::Not:
+		expr = klee::NotExpr::alloc(getExpr(readInt<uint32_t>(stream)));
+		break;
+	case klee::Expr::ZExt:
+	case klee::Expr::SExt: {
+		auto kid = getExpr(readInt<uint32_t>(stream));
+		expr = klee::Expr::createFromKind(kind, {kid, width});
+		break;
+	}
+	case klee::Expr::NotOptimized:
+		expr = klee::Expr::createFromKind(kind, {getExpr(readInt<uint32_t>(stream))});
+		break;
+	case klee::Expr::Select: {
+		auto cond = getExpr(readInt<uint32_t>(stream));
+		auto texpr = getExpr(readInt<uint32_t>(stream));
+		auto fexpr = getExpr(readInt<uint32_t>(stream));
+		expr = klee::Expr::createFromKind(kind, {cond, texpr, fexpr});
+		break;
+	}
+	default: {
+		if (kind < klee::Expr::Concat || kind > klee::Expr::LastKind)
+			throw std::runtime_error("invalid expression kind");
+
+		auto lhs = getExpr(readInt<uint32_t>(stream));
+		auto rhs = getExpr(readInt<uint32_t>(stream));
+		expr = klee::Expr::createFromKind(kind, {lhs, rhs});
+		break;
+	}
+	}
+
+	exprs.push_back(expr);
+}
+
+Ref<BitVector>
+ExprReader::read(std::istream &stream)
+{
+	for (;;) {
+		auto type = readInt<uint8_t>(stream);
+		switch (type) {
+		case RECORD_ARRAY:
+			readArray(stream);
+			break;
+		case RECORD_UPDATE:
+			readUpdate(stream);
+			break;
+		case RECORD_EXPR:
+			readExpr(stream);
+			break;
+		case RECORD_END:
+			return Ref<BitVector>(new BitVector(getExpr(readInt<uint32_t>(stream))));
+		default:
+			throw std::runtime_error("invalid record in serialized expression");
+		}
+	}
+}
+
+/* Execution trees are written in pre-order, each node is prefixed
+ * with one of the following tags. Branch conditions of all nodes
+ * share a single ExprWriter and are thus deduplicated. */
+enum NodeTag : uint8_t {
+	NODE_NONE = 0,
+	NODE_PLACEHOLDER = 1,
+	NODE_BRANCH = 2,
+};
+
+static const char treeMagic[] = {'C', 'L', 'V', 'T'};
+#define TREE_VERSION 1
+
+void
+Trace::save(std::ostream &stream)
+{
+	ExprWriter writer;
+	std::vector<Node *> nodes;
+
+	stream.write(treeMagic, sizeof(treeMagic));
+	writeInt<uint32_t>(stream, TREE_VERSION);
+
+	// Iterative traversal, trees can be deeper than the stack permits.
+	nodes.push_back(pathCondsRoot);
+	while (!nodes.empty()) {
+		Node *node = nodes.back();
+		nodes.pop_back();
+
+		if (!node) {
+			writeInt<uint8_t>(stream, NODE_NONE);
+			continue;
+		} else if (node->isPlaceholder()) {
+			writeInt<uint8_t>(stream, NODE_PLACEHOLDER);
+			writeInt<uint32_t>(stream, node->generation);
+			continue;
+		}
+
+		writeInt<uint8_t>(stream, NODE_BRANCH);
+		writeInt<uint32_t>(stream, node->generation);
+		writeInt<uint8_t>(stream, node->value->wasNegated);
+		writeInt<uint32_t>(stream, node->value->addr);
+		writer.write(stream, node->value->bv);
+
+		nodes.push_back(node->false_branch);
+		nodes.push_back(node->true_branch);
+	}
+
+	if (!stream)
+		throw std::runtime_error("failed to write execution tree");
+}
+
+void
+Trace::load(std::istream &stream)
+{
+	ExprReader reader(solver);
+	char magic[sizeof(treeMagic)];
+
+	if (!stream.read(magic, sizeof(magic)) || memcmp(magic, treeMagic, sizeof(magic)))
+		throw std::runtime_error("not a serialized execution tree");
+	if (readInt<uint32_t>(stream) != TREE_VERSION)
+		throw std::runtime_error("unsupported execution tree version");
+
+	// Each slot refers to the location where the next node is stored.
+	std::vector<std::pair<Node *, Node **>> slots;
+	Node *root = nullptr;
+
+	slots.push_back(std::make_pair(nullptr, &root));
+	try {
+		while (!slots.empty()) {
+			auto slot = slots.back();
+			slots.pop_back();
+
+			auto tag = readInt<uint8_t>(stream);
+			if (tag == NODE_NONE)
+				continue;
+			else if (tag != NODE_PLACEHOLDER && tag != NODE_BRANCH)
+				throw std::runtime_error("invalid node in execution tree");
+
+			Node *node = new Node(slot.first, readInt<uint32_t>(stream));
+			*slot.second = node;
+			if (tag == NODE_PLACEHOLDER)
+				continue;
+
+			bool wasNegated = readInt<uint8_t>(stream);
+			uint32_t addr = readInt<uint32_t>(stream);
+			auto bv = reader.read(stream);
+			node->value = std::make_shared<Branch>(Branch(bv, wasNegated, addr));
+
+			slots.push_back(std::make_pair(node, &node->false_branch));
+			slots.push_back(std::make_pair(node, &node->true_branch));
+		}
+	} catch (...) {
+		if (root)
+			deleteTree(root);
+		throw;
+	}
+
+	if (!root)
+		throw std::runtime_error("execution tree without root");
+
+	deferred.clear();
+	deleteTree(pathCondsRoot);
+	pathCondsRoot = root;
+	pathCondsCurrent = nullptr;
+
+	rebuildFrontier();
+}
@@ -0,0 +1,89 @@
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+void
+BranchSites::setBudget(uint64_t _budget, double _decay)
+{
+	if (!(_decay > 0.0 && _decay <= 1.0))
+		throw std::invalid_argument("decay factor must be in (0, 1]");
+
+	budget = _budget;
+	decay = _decay;
+}
+
+bool
+BranchSites::hasDecay(void) const
+{
+	return budget > 0 && decay < 1.0;
+}
+
+double
+BranchSites::getLoad(const Site &site) const
+{
+	if (decay == 1.0)
+		return site.load;
+	return site.load * pow(decay, ticks - site.tick);
+}
+
+double
+BranchSites::getLoad(uint32_t addr) const
+{
+	auto it = sites.find(addr);
+	return (it == sites.end()) ? 0.0 : getLoad(it->second);
+}
+
+void
+BranchSites::negated(uint32_t addr, bool newPath)
+{
+	Site &site = sites[addr];
+
+	site.stats.negations++;
+	if (newPath)
+		site.stats.paths++;
+
+	site.load = getLoad(site) + 1.0;
+	site.tick = ++ticks;
+}
+
+bool
+BranchSites::isSaturated(uint32_t addr) const
+{
+	if (budget == 0)
+		return false;
+	return getLoad(addr) >= (double)budget;
+}
+
+std::vector<std::pair<uint32_t, BranchSites::Stats>>
+BranchSites::getStats(void) const
+{
+	std::vector<std::pair<uint32_t, Stats>> stats;
+
+	for (auto &site : sites)
+		stats.push_back(std::make_pair(site.first, site.second.stats));
+	std::sort(stats.begin(), stats.end(), [](auto &a, auto &b) {
+		if (a.second.negations == b.second.negations)
+			return a.first < b.first;
+		return a.second.negations > b.second.negations;
+	});
+
+	return stats;
+}
+
+size_t
+BranchSites::countSaturated(void) const
+{
+	size_t n = 0;
+
+	for (auto &site : sites) {
+		if (isSaturated(site.first))
+			n++;
+	}
+
+	return n;
+}
@@ -16,12 +16,19 @@ Solver::Solver(klee::Solver *_solver)
 	if (!_solver)
 		_solver = klee::createCoreSolver(klee::CoreSolverType::Z3_SOLVER);
 
+	// Each layer is wrapped for profiling, see getProfile().
+	_solver = profile.wrap("core", _solver);
+
+	// Queries reaching the core solver may be answered by the
+	// persistent cache, see setQueryCache().
+	_solver = profile.wrap("query-cache", cache.createSolver(_solver));
+
 	// Create fancy solver chain based on given core solver.
 	// Taken from lib/Solver/ConstructSolverChain.cpp
-	_solver = klee::createFastCexSolver(_solver);
-	_solver = klee::createCexCachingSolver(_solver);
-	_solver = klee::createCachingSolver(_solver);
-	_solver = klee::createIndependentSolver(_solver);
+	_solver = profile.wrap("fast-cex", klee::createFastCexSolver(_solver));
+	_solver = profile.wrap("cex-caching", klee::createCexCachingSolver(_solver));
+	_solver = profile.wrap("caching", klee::createCachingSolver(_solver));
+	_solver = profile.wrap("independent", klee::createIndependentSolver(_solver));
 
 	// Copied from tools/kleaver/main.cpp
 	builder = klee::createDefaultExprBuilder();
@@ -44,6 +51,18 @@ Solver::setTimeout(klee::time::Span timeout)
 	this->solver->setCoreSolverTimeout(timeout);
 }
 
+void
+Solver::setQueryCache(std::string path)
+{
+	cache.open(path);
+}
+
+SolverProfile &
+Solver::getProfile(void)
+{
+	return profile;
+}
+
 std::optional<klee::Assignment>
 Solver::getAssignment(const klee::Query &query)
 {
@@ -61,8 +80,10 @@ Solver::getAssignment(const klee::Query &query)
 	// and return if it is. Otherwise triggers an assert statement
 	// in the getAllIndependentConstraintsSets function.
 	auto ce = dyn_cast<klee::ConstantExpr>(nq.expr);
-	if (ce && ce->isTrue())
+	if (ce && ce->isTrue()) {
+		profile.setOrigin(0); // no query issued
 		return std::nullopt;
+	}
 
 	std::vector<std::vector<unsigned char>> values;
 	if (!solver->getInitialValues(nq, objects, values))
@@ -92,26 +113,41 @@ Solver::eval(const klee::Query &query)
 	return false;
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
 Solver::BVC(std::optional<std::string> name, IntValue value)
 {
-	auto concrete = std::make_shared<BitVector>(BitVector(value));
-	if (!name.has_value()) {
-		auto concolic = ConcolicValue(builder, concrete);
-		return std::make_shared<ConcolicValue>(concolic);
-	}
+	auto concrete = ConcreteValue(intToUint(value), intByteSize(value) * 8);
+	if (!name.has_value())
+		return Ref<ConcolicValue>(new ConcolicValue(builder, concrete));
 
 	auto array = array_cache.CreateArray(*name, intByteSize(value));
-	auto symbolic = std::make_shared<BitVector>(BitVector(array));
+	auto symbolic = Ref<BitVector>(new BitVector(array));
 
-	auto concolic = ConcolicValue(builder, concrete, symbolic);
-	return std::make_shared<ConcolicValue>(concolic);
+	return Ref<ConcolicValue>(new ConcolicValue(builder, concrete, symbolic));
 }
 
-std::shared_ptr<ConcolicValue>
+Ref<ConcolicValue>
+Solver::BVC(ConcreteValue value)
+{
+	return Ref<ConcolicValue>(new ConcolicValue(builder, value));
+}
+
+Ref<ConcolicValue>
 Solver::BVC(uint8_t *buf, size_t buflen, bool lsb)
 {
-	std::shared_ptr<ConcolicValue> result = nullptr;
+	if (buflen > 0 && buflen <= sizeof(uint64_t)) {
+		uint64_t value = 0;
+		for (size_t i = 0; i < buflen; i++) {
+			if (lsb)
+				value = (value << 8) | buf[i];
+			else
+				value |= (uint64_t)buf[i] << (i * 8);
+		}
+
+		return BVC(ConcreteValue(value, buflen * 8));
+	}
+
+	Ref<ConcolicValue> result = nullptr;
 	for (size_t i = 0; i < buflen; i++) {
 		auto byte = BVC(std::nullopt, (uint8_t)buf[i]);
 		if (!result) {
@@ -128,8 +164,15 @@ Solver::BVC(uint8_t *buf, size_t buflen, bool lsb)
 }
 
 void
-Solver::BVCToBytes(std::shared_ptr<ConcolicValue> value, uint8_t *buf, size_t buflen)
+Solver::BVCToBytes(Ref<ConcolicValue> value, uint8_t *buf, size_t buflen)
 {
+	if (value->concrete.isInline()) {
+		uint64_t v = value->concrete.getZExtValue();
+		for (size_t i = 0; i < buflen; i++)
+			buf[i] = (i < sizeof(v)) ? (uint8_t)(v >> (i * 8)) : 0;
+		return;
+	}
+
 	if (value->getWidth() < buflen * 8)
 		value = value->zext(buflen * 8);
 
@@ -140,7 +183,7 @@ Solver::BVCToBytes(std::shared_ptr<ConcolicValue> value, uint8_t *buf, size_t bu
 	}
 }
 
-std::shared_ptr<BitVector>
+Ref<BitVector>
 Solver::fromString(Env env, std::string kquery)
 {
 	auto mb = llvm::MemoryBuffer::getMemBuffer(kquery.c_str());
@@ -151,5 +194,5 @@ Solver::fromString(Env env, std::string kquery)
 		vars[p.first] = p.second->expr;
 
 	auto expr = par->ParseSingleConstraint(vars);
-	return std::make_shared<BitVector>(BitVector(expr));
+	return Ref<BitVector>(new BitVector(expr));
 }
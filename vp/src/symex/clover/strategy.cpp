@@ -0,0 +1,123 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <set>
+#include <unordered_map>
+
+#include <clover/clover.h>
+
+using namespace clover;
+
+SearchStrategy::~SearchStrategy(void)
+{
+	return;
+}
+
+void
+SearchStrategy::visit(uint32_t addr, bool condition)
+{
+	(void)addr;
+	(void)condition;
+}
+
+void
+SearchStrategy::negated(const Candidate &candidate)
+{
+	(void)candidate;
+}
+
+/* Negate the deepest branch first. */
+class DepthFirstStrategy : public SearchStrategy {
+public:
+	int64_t priority(const Candidate &candidate)
+	{
+		return candidate.depth;
+	}
+};
+
+/* Negate the branch closest to the root first. */
+class BreadthFirstStrategy : public SearchStrategy {
+public:
+	int64_t priority(const Candidate &candidate)
+	{
+		return -(int64_t)candidate.depth;
+	}
+};
+
+/* Negate branches of paths with the lowest generation first. Similar
+ * to SAGE, all branches of a path are thus negated before any of the
+ * paths resulting from these negations are expanded further. */
+class GenerationalStrategy : public SearchStrategy {
+public:
+	int64_t priority(const Candidate &candidate)
+	{
+		return -(int64_t)candidate.generation;
+	}
+};
+
+/* Prefer branches whose unexplored direction was not yet observed
+ * on any path, i.e. which increase branch coverage when negated. */
+class UncoveredFirstStrategy : public SearchStrategy {
+private:
+	std::set<std::pair<uint32_t, bool>> covered;
+
+public:
+	void visit(uint32_t addr, bool condition)
+	{
+		covered.insert(std::make_pair(addr, condition));
+	}
+
+	int64_t priority(const Candidate &candidate)
+	{
+		return covered.count(std::make_pair(candidate.addr, candidate.condition)) ? 0 : 1;
+	}
+};
+
+/* Distribute negations evenly across branch instructions, thereby
+ * preventing a single branch instruction (e.g. a loop condition)
+ * from dominating the exploration. */
+class RoundRobinStrategy : public SearchStrategy {
+private:
+	std::unordered_map<uint32_t, uint64_t> negations;
+
+public:
+	void negated(const Candidate &candidate)
+	{
+		negations[candidate.addr]++;
+	}
+
+	int64_t priority(const Candidate &candidate)
+	{
+		auto it = negations.find(candidate.addr);
+		return (it == negations.end()) ? 0 : -(int64_t)it->second;
+	}
+};
+
+const std::vector<std::string> &
+SearchStrategy::names(void)
+{
+	static const std::vector<std::string> names = {
+		"random", "dfs", "bfs", "generational", "uncovered", "roundrobin",
+	};
+
+	return names;
+}
+
+std::unique_ptr<SearchStrategy>
+SearchStrategy::create(std::string name)
+{
+	if (name == "random")
+		return nullptr;
+	else if (name == "dfs")
+		return std::make_unique<DepthFirstStrategy>();
+	else if (name == "bfs")
+		return std::make_unique<BreadthFirstStrategy>();
+	else if (name == "generational")
+		return std::make_unique<GenerationalStrategy>();
+	else if (name == "uncovered")
+		return std::make_unique<UncoveredFirstStrategy>();
+	else if (name == "roundrobin")
+		return std::make_unique<RoundRobinStrategy>();
+
+	throw std::invalid_argument("unknown search strategy: " + name);
+}
@@ -79,7 +79,7 @@ parseAssign(std::string assign)
 }
 
 ConcreteStore
-TestCase::fromFile(std::string name, std::ifstream &stream)
+TestCase::fromFile(std::string name, std::istream &stream)
 {
 	ConcreteStore assigns;
 
@@ -100,7 +100,7 @@ TestCase::fromFile(std::string name, std::ifstream &stream)
 }
 
 void
-TestCase::toFile(ConcreteStore store, std::ofstream &stream)
+TestCase::toFile(ConcreteStore store, std::ostream &stream)
 {
 	for (auto assign : store) {
 		// Output variable name
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <queue>
 
 #include <assert.h>
@@ -22,10 +23,16 @@ Trace::Trace(Solver &_solver)
 }
 
 Trace::~Trace(void)
+{
+	deleteTree(pathCondsRoot);
+}
+
+void
+Trace::deleteTree(Node *root)
 {
 	std::queue<Node *> nodes;
 
-	nodes.push(pathCondsRoot);
+	nodes.push(root);
 	while (!nodes.empty()) {
 		Node *node = nodes.front();
 		nodes.pop();
@@ -47,13 +54,219 @@ Trace::reset(void)
 }
 
 bool
-Trace::addBranch(std::shared_ptr<Trace::Branch> branch, bool condition)
+Trace::FrontierEntry::operator<(const FrontierEntry &other) const
+{
+	// Prefer the most recently added entry on equal priority.
+	if (priority == other.priority)
+		return seq < other.seq;
+	return priority < other.priority;
+}
+
+int64_t
+Trace::getPriority(Node *node)
+{
+	// Negated assume conditions (see Trace::assume) use address zero,
+	// these need to be enforced before negating any other branch.
+	if (node->value->addr == 0)
+		return INT64_MAX;
+
+	return strategy->priority(node->toCandidate());
+}
+
+void
+Trace::pushCandidate(Node *node)
+{
+	frontier.push(FrontierEntry{getPriority(node), frontierSeq++, node});
+}
+
+Trace::Node *
+Trace::nextCandidate(void)
+{
+	while (!frontier.empty()) {
+		FrontierEntry entry = frontier.top();
+		frontier.pop();
+
+		// Entries are not removed when a node stops being a candidate.
+		Node *node = entry.node;
+		if (!node->isCandidate())
+			continue;
+
+		// Re-insert the node if its priority decreased meanwhile.
+		int64_t priority = getPriority(node);
+		if (priority < entry.priority) {
+			frontier.push(FrontierEntry{priority, entry.seq, node});
+			continue;
+		}
+
+		return node;
+	}
+
+	return nullptr;
+}
+
+Trace::Node *
+Trace::findNode(const Path &path)
+{
+	Node *node = pathCondsRoot;
+
+	// The last element refers to the node itself.
+	for (size_t i = 0; i + 1 < path.size(); i++)
+		node = (path[i].second) ? node->true_branch : node->false_branch;
+
+	assert(node && node->value == path.back().first);
+	return node;
+}
+
+bool
+Trace::isSaturated(Node *node)
+{
+	// Negated assume conditions are never deferred, see getPriority().
+	return node->value->addr != 0 && sites.isSaturated(node->value->addr);
+}
+
+void
+Trace::resumeDeferred(void)
+{
+	for (size_t i = 0; i < deferred.size();) {
+		Node *node = deferred[i];
+		if (node->isCandidate() && isSaturated(node)) {
+			i++;
+			continue;
+		}
+
+		node->value->deferred = false;
+		if (strategy && node->isCandidate())
+			pushCandidate(node);
+
+		deferred[i] = deferred.back();
+		deferred.pop_back();
+	}
+}
+
+Trace::Node *
+Trace::takeDeferred(void)
+{
+	Node *best = nullptr;
+	size_t bestIdx = 0;
+	double bestLoad = 0;
+
+	for (size_t i = 0; i < deferred.size();) {
+		Node *node = deferred[i];
+		if (!node->isCandidate()) {
+			deferred[i] = deferred.back();
+			deferred.pop_back();
+			continue;
+		}
+
+		double load = sites.getLoad(node->value->addr);
+		if (!best || load < bestLoad) {
+			best = node;
+			bestIdx = i;
+			bestLoad = load;
+		}
+		i++;
+	}
+
+	if (!best)
+		return nullptr;
+
+	best->value->deferred = false;
+	deferred[bestIdx] = deferred.back();
+	deferred.pop_back();
+	return best;
+}
+
+Trace::Node *
+Trace::selectCandidate(void)
+{
+	// Decayed sites may no longer be saturated.
+	if (sites.hasDecay())
+		resumeDeferred();
+
+	for (;;) {
+		Node *node;
+		if (strategy) {
+			if (!(node = nextCandidate()))
+				break;
+		} else {
+			Path path;
+			if (!pathCondsRoot->randomUnnegated(path))
+				break;
+			node = findNode(path);
+		}
+
+		if (!isSaturated(node))
+			return node;
+
+		node->value->deferred = true;
+		deferred.push_back(node);
+	}
+
+	// Only candidates of saturated sites are left, negate those
+	// of the least saturated site first.
+	return takeDeferred();
+}
+
+BranchSites &
+Trace::getSites(void)
+{
+	return sites;
+}
+
+void
+Trace::setStrategy(std::unique_ptr<SearchStrategy> _strategy)
+{
+	strategy = std::move(_strategy);
+	rebuildFrontier();
+}
+
+void
+Trace::rebuildFrontier(void)
+{
+	std::queue<Node *> nodes;
+
+	frontier = std::priority_queue<FrontierEntry>();
+	if (!strategy)
+		return;
+
+	nodes.push(pathCondsRoot);
+	while (!nodes.empty()) {
+		Node *node = nodes.front();
+		nodes.pop();
+		if (node->isPlaceholder())
+			continue;
+
+		// Replay the existing tree to initialize strategy state.
+		if (node->value->wasNegated)
+			strategy->negated(node->toCandidate());
+		if (node->true_branch) {
+			strategy->visit(node->value->addr, true);
+			nodes.push(node->true_branch);
+		}
+		if (node->false_branch) {
+			strategy->visit(node->value->addr, false);
+			nodes.push(node->false_branch);
+		}
+
+		if (node->isCandidate())
+			pushCandidate(node);
+	}
+}
+
+void
+Trace::setForward(ForwardFn fn)
+{
+	forward = fn;
+}
+
+bool
+Trace::addBranch(Node *&current, std::shared_ptr<Trace::Branch> branch, bool condition)
 {
 	bool ret = false;
 
 	Node *node = nullptr;
-	if (pathCondsCurrent != nullptr) {
-		node = pathCondsCurrent;
+	if (current != nullptr) {
+		node = current;
 	} else {
 		node = pathCondsRoot;
 	}
@@ -64,21 +277,40 @@ Trace::addBranch(std::shared_ptr<Trace::Branch> branch, bool condition)
 		ret = true;
 	}
 
-	if (condition) {
-		if (!node->true_branch)
-			node->true_branch = new Node;
-		pathCondsCurrent = node->true_branch;
-	} else {
-		if (!node->false_branch)
-			node->false_branch = new Node;
-		pathCondsCurrent = node->false_branch;
+	// If the other direction was already explored, the new child
+	// node was discovered by negating this node.
+	Node *&child = (condition) ? node->true_branch : node->false_branch;
+	Node *other = (condition) ? node->false_branch : node->true_branch;
+	if (!child)
+		child = new Node(node, node->generation + ((other) ? 1 : 0));
+	current = child;
+
+	if (strategy) {
+		strategy->visit(node->value->addr, condition);
+		if (ret)
+			pushCandidate(node);
 	}
 
 	return ret;
 }
 
+bool
+Trace::addBranch(std::shared_ptr<Trace::Branch> branch, bool condition, bool needResult)
+{
+	if (forward)
+		return forward(condition, branch->bv, branch->addr, needResult);
+	return addBranch(pathCondsCurrent, branch, condition);
+}
+
+bool
+Trace::extend(Cursor &cursor, bool condition, Ref<BitVector> bv, uint32_t pc)
+{
+	auto br = std::make_shared<Branch>(Branch(bv, false, pc));
+	return addBranch(cursor, br, condition);
+}
+
 void
-Trace::add(bool condition, std::shared_ptr<BitVector> bv, uint32_t pc)
+Trace::add(bool condition, Ref<BitVector> bv, uint32_t pc)
 {
 	auto c = (condition) ? bv->eqTrue() : bv->eqFalse();
 	cm.addConstraint(c->expr);
@@ -88,7 +320,7 @@ Trace::add(bool condition, std::shared_ptr<BitVector> bv, uint32_t pc)
 }
 
 void
-Trace::assume(std::shared_ptr<BitVector> bv)
+Trace::assume(Ref<BitVector> bv)
 {
 	// Enforce condition as true for this execution path.
 	auto c = bv->eqTrue();
@@ -100,7 +332,7 @@ Trace::assume(std::shared_ptr<BitVector> bv)
 	// restart and thus enforced from this point onwards.
 	auto negated_assume = bv->eqFalse();
 	auto br = std::make_shared<Branch>(Branch(negated_assume, false, 0));
-	if (addBranch(br, false)) {
+	if (addBranch(br, false, true)) {
 		// If we add a new node to the tree then this is the
 		// first time this constraint gets enforced and we
 		// need to find new assignments for all concolic values.
@@ -109,7 +341,7 @@ Trace::assume(std::shared_ptr<BitVector> bv)
 }
 
 klee::Query
-Trace::getQuery(std::shared_ptr<BitVector> bv)
+Trace::getQuery(Ref<BitVector> bv)
 {
 	auto expr = cm.simplifyExpr(cs, bv->expr);
 	return klee::Query(cs, expr);
@@ -152,19 +384,72 @@ Trace::findNewPath(void)
 	do {
 		klee::ConstraintSet cs;
 
-		Path path;
-		if (!pathCondsRoot->randomUnnegated(path))
+		Node *node = selectCandidate();
+		if (!node)
 			return std::nullopt; /* all branches exhausted */
+		if (strategy)
+			strategy->negated(node->toCandidate());
 
+		Path path = node->getPath();
 		auto query = newQuery(cs, path);
 		/* std::cout << "Attempting to negate new query at: 0x" << std::hex << path.back().first->addr << std::dec << std::endl; */
+		solver.getProfile().setOrigin(node->value->addr);
 		assign = solver.getAssignment(query);
+		if (node->value->addr != 0)
+			sites.negated(node->value->addr, assign.has_value());
 	} while (!assign.has_value()); /* loop until we found a sat assignment */
 
 	assert(assign.has_value());
 	return assign;
 }
 
+Trace::Cursor
+Trace::getCursor(void)
+{
+	return pathCondsCurrent;
+}
+
+std::vector<klee::Assignment>
+Trace::findNewPaths(Cursor cursor)
+{
+	std::vector<klee::Assignment> assigns;
+
+	Path path;
+	for (Node *n = cursor; n && n->parent; n = n->parent)
+		path.push_back(std::make_pair(n->parent->value, n->parent->true_branch == n));
+	std::reverse(path.begin(), path.end());
+
+	// Unlike newQuery(), constraints for the path prefix are only
+	// added once and shared by all queries created for this path.
+	klee::ConstraintSet cs;
+	auto cm = klee::ConstraintManager(cs);
+
+	Node *node = pathCondsRoot;
+	for (auto elem : path) {
+		auto branch = elem.first;
+		auto cond = elem.second;
+		auto bvcond = (cond) ? branch->bv->eqTrue() : branch->bv->eqFalse();
+
+		if (node->isCandidate() && branch->addr != 0 && !isSaturated(node)) {
+			if (strategy)
+				strategy->negated(node->toCandidate());
+			branch->wasNegated = true;
+
+			auto expr = cm.simplifyExpr(cs, bvcond->expr);
+			solver.getProfile().setOrigin(branch->addr);
+			auto assign = solver.getAssignment(klee::Query(cs, expr).negateExpr());
+			sites.negated(branch->addr, assign.has_value());
+			if (assign.has_value())
+				assigns.push_back(*assign);
+		}
+
+		cm.addConstraint(bvcond->expr);
+		node = (cond) ? node->true_branch : node->false_branch;
+	}
+
+	return assigns;
+}
+
 ConcreteStore
 Trace::getStore(const klee::Assignment &assign)
 {
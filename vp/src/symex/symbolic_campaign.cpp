@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include "symbolic_campaign.h"
+
+static const char campaignMagic[] = {'S', 'Y', 'M', 'C'};
+#define CAMPAIGN_VERSION 2
+
+template <typename T>
+static void
+writeInt(std::ostream &stream, T value)
+{
+	stream.write((char *)&value, sizeof(value));
+}
+
+template <typename T>
+static T
+readInt(std::istream &stream)
+{
+	T value;
+
+	if (!stream.read((char *)&value, sizeof(value)))
+		throw std::runtime_error("truncated campaign file");
+	return value;
+}
+
+static void
+writeString(std::ostream &stream, const std::string &str)
+{
+	writeInt<uint64_t>(stream, str.size());
+	stream.write(str.data(), str.size());
+}
+
+static std::string
+readString(std::istream &stream)
+{
+	std::string str(readInt<uint64_t>(stream), '\0');
+	if (!stream.read(str.data(), str.size()))
+		throw std::runtime_error("truncated campaign file");
+	return str;
+}
+
+static void
+writeStore(std::ostream &stream, const clover::ConcreteStore &store)
+{
+	std::ostringstream text;
+
+	clover::TestCase::toFile(store, text);
+	writeString(stream, text.str());
+}
+
+static clover::ConcreteStore
+readStore(std::istream &stream)
+{
+	std::istringstream text(readString(stream));
+	return clover::TestCase::fromFile("campaign", text);
+}
+
+void
+Campaign::save(std::string path, clover::Trace &trace)
+{
+	std::string tmp = path + ".tmp";
+	std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + tmp);
+
+	file.write(campaignMagic, sizeof(campaignMagic));
+	writeInt<uint32_t>(file, CAMPAIGN_VERSION);
+	writeInt<uint64_t>(file, paths_found);
+	writeInt<double>(file, solver_time.count());
+	writeInt<double>(file, pipelined_time.count());
+
+	trace.save(file);
+
+	writeInt<uint64_t>(file, pending.size());
+	for (auto &store : pending)
+		writeStore(file, store);
+
+	writeInt<uint64_t>(file, testcases.size());
+	for (auto &testcase : testcases) {
+		writeString(file, testcase.first);
+		writeStore(file, testcase.second);
+	}
+
+	file.close();
+	if (!file)
+		throw std::runtime_error("failed to write " + tmp);
+	if (rename(tmp.c_str(), path.c_str()) == -1)
+		throw std::system_error(errno, std::generic_category());
+}
+
+bool
+Campaign::load(std::string path, clover::Trace &trace)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[sizeof(campaignMagic)];
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, campaignMagic, sizeof(magic)))
+		throw std::runtime_error(path + " is not a campaign file");
+	auto version = readInt<uint32_t>(file);
+	if (version < 1 || version > CAMPAIGN_VERSION)
+		throw std::runtime_error(path + " has an unsupported version");
+
+	paths_found = readInt<uint64_t>(file);
+	solver_time = std::chrono::duration<double, std::milli>(readInt<double>(file));
+
+	// Version 1 did not account pipelined solver time separately.
+	pipelined_time = std::chrono::duration<double, std::milli>(0);
+	if (version >= 2)
+		pipelined_time = std::chrono::duration<double, std::milli>(readInt<double>(file));
+
+	trace.load(file);
+
+	pending.clear();
+	for (auto n = readInt<uint64_t>(file); n > 0; n--)
+		pending.push_back(readStore(file));
+
+	testcases.clear();
+	for (auto n = readInt<uint64_t>(file); n > 0; n--) {
+		auto name = readString(file);
+		testcases.push_back(std::make_pair(name, readStore(file)));
+	}
+
+	return true;
+}
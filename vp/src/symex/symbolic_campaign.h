@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_ISA_SYMBOLIC_CAMPAIGN_H
+#define RISCV_ISA_SYMBOLIC_CAMPAIGN_H
+
+#include <stddef.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <clover/clover.h>
+
+/* State of an exploration campaign which is preserved across multiple
+ * invocations of the VP. Besides the members of this class, the file
+ * also contains the execution tree of the given clover::Trace. */
+class Campaign {
+public:
+	size_t paths_found = 0;
+	std::chrono::duration<double, std::milli> solver_time;
+	std::chrono::duration<double, std::milli> pipelined_time;
+
+	// Concrete stores for which no execution has completed yet.
+	std::deque<clover::ConcreteStore> pending;
+
+	// Names and concrete stores of all test cases found so far.
+	std::vector<std::pair<std::string, clover::ConcreteStore>> testcases;
+
+	/* The file is replaced atomically, an interrupted save thus
+	 * retains the previous state of the campaign. */
+	void save(std::string path, clover::Trace &trace);
+
+	/* Returns false if no campaign exists at the given path. */
+	bool load(std::string path, clover::Trace &trace);
+};
+
+#endif
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#include "symbolic_checkpoint.h"
+
+/* Messages exchanged between explorer and runner processes. Each
+ * message is prefixed with its length and starts with its type. */
+enum MessageType : char {
+	MSG_BRANCH = 'B',
+	MSG_TESTCASE = 'T',
+	MSG_RESULT = 'R',
+};
+
+template <typename T>
+static void
+writeInt(std::ostream &stream, T value)
+{
+	stream.write((char *)&value, sizeof(value));
+}
+
+template <typename T>
+static T
+readInt(std::istream &stream)
+{
+	T value;
+
+	if (!stream.read((char *)&value, sizeof(value)))
+		throw std::runtime_error("truncated checkpoint message");
+	return value;
+}
+
+static void
+writeAll(int fd, const void *buf, size_t len)
+{
+	const char *p = (const char *)buf;
+
+	while (len > 0) {
+		ssize_t r = send(fd, p, len, MSG_NOSIGNAL);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		}
+
+		p += r;
+		len -= r;
+	}
+}
+
+static bool
+readAll(int fd, void *buf, size_t len)
+{
+	char *p = (char *)buf;
+
+	while (len > 0) {
+		ssize_t r = read(fd, p, len);
+		if (r == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		} else if (r == 0) {
+			return false; // EOF
+		}
+
+		p += r;
+		len -= r;
+	}
+
+	return true;
+}
+
+static void
+sendMsg(int fd, const std::string &msg)
+{
+	uint32_t len = msg.size();
+
+	writeAll(fd, &len, sizeof(len));
+	writeAll(fd, msg.data(), len);
+}
+
+static std::optional<std::string>
+recvMsg(int fd)
+{
+	uint32_t len;
+
+	if (!readAll(fd, &len, sizeof(len)))
+		return std::nullopt;
+
+	std::string msg(len, '\0');
+	if (!readAll(fd, msg.data(), len))
+		return std::nullopt;
+
+	return msg;
+}
+
+static void
+sendFd(int sock, int fd)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	char data = 0;
+	char cbuf[CMSG_SPACE(sizeof(fd))];
+
+	memset(&msg, 0, sizeof(msg));
+	memset(cbuf, 0, sizeof(cbuf));
+
+	iov.iov_base = &data;
+	iov.iov_len = sizeof(data);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fd));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+	while (sendmsg(sock, &msg, MSG_NOSIGNAL) == -1) {
+		if (errno != EINTR)
+			throw std::system_error(errno, std::generic_category());
+	}
+}
+
+static int
+recvFd(int sock)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	char data;
+	char cbuf[CMSG_SPACE(sizeof(int))];
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &data;
+	iov.iov_len = sizeof(data);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	ssize_t r;
+	while ((r = recvmsg(sock, &msg, 0)) == -1 && errno == EINTR)
+		;
+	if (r <= 0)
+		return -1;
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS)
+		return -1;
+
+	int fd;
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+	return fd;
+}
+
+static void
+flushAll(void)
+{
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(NULL);
+}
+
+/* Terminate the calling process when the given parent terminates. */
+static void
+dieWithParent(pid_t parent)
+{
+	if (prctl(PR_SET_PDEATHSIG, SIGKILL) == -1)
+		_exit(EXIT_FAILURE);
+	if (getppid() != parent)
+		_exit(EXIT_FAILURE); // parent already terminated
+}
+
+Checkpoint::Runner::Runner(int _fd, clover::Solver &solver)
+    : fd(_fd), reader(solver)
+{
+	return;
+}
+
+Checkpoint::Runner::~Runner(void)
+{
+	close(fd);
+}
+
+int
+Checkpoint::Runner::getFd(void)
+{
+	return fd;
+}
+
+Checkpoint::Checkpoint(SymbolicContext &_sctx, TestCaseHandler _onTestCase, bool _tracing)
+    : sctx(_sctx), onTestCase(_onTestCase), tracing(_tracing)
+{
+	return;
+}
+
+Checkpoint::~Checkpoint(void)
+{
+	if (ctrlfd == -1)
+		return;
+
+	// Closing the control socket terminates the server process.
+	close(ctrlfd);
+	waitpid(server, NULL, 0);
+}
+
+bool
+Checkpoint::available(void)
+{
+	return ctrlfd != -1;
+}
+
+bool
+Checkpoint::isRunner(void)
+{
+	return runnerfd != -1;
+}
+
+bool
+Checkpoint::create(void)
+{
+	int fds[2];
+
+	assert(!available() && !isRunner());
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+		throw std::system_error(errno, std::generic_category());
+
+	flushAll(); // Don't duplicate buffered output
+	pid_t explorer = getpid();
+	pid_t pid = fork();
+	if (pid == -1) {
+		throw std::system_error(errno, std::generic_category());
+	} else if (pid) {
+		close(fds[1]);
+		ctrlfd = fds[0];
+		server = pid;
+		return false;
+	}
+
+	close(fds[0]);
+	dieWithParent(explorer);
+
+	// Only returns in runner processes.
+	int fd = serve(fds[1]);
+	setupRunner(fd);
+
+	return true;
+}
+
+int
+Checkpoint::serve(int fd)
+{
+	pid_t self = getpid();
+
+	// Runner processes are never waited for, reap them automatically.
+	signal(SIGCHLD, SIG_IGN);
+
+	for (;;) {
+		int runner = recvFd(fd);
+		if (runner == -1)
+			_exit(EXIT_SUCCESS); // explorer closed control socket
+
+		pid_t pid = fork();
+		if (pid == -1) {
+			close(runner); // explorer detects failure through EOF
+			continue;
+		} else if (pid == 0) {
+			signal(SIGCHLD, SIG_DFL);
+			close(fd);
+			dieWithParent(self);
+			return runner;
+		}
+
+		close(runner);
+	}
+}
+
+void
+Checkpoint::setupRunner(int fd)
+{
+	runnerfd = fd;
+
+	auto msg = recvMsg(fd);
+	if (!msg.has_value())
+		_exit(EXIT_FAILURE);
+
+	std::istringstream stream(*msg);
+	auto store = clover::TestCase::fromFile("checkpoint", stream);
+
+	sctx.ctx.setupNewValues(store);
+	sctx.limits.start();
+	evals_base = sctx.concrete_evals.get();
+	if (!tracing)
+		return;
+
+	writer.emplace();
+	sctx.trace.setForward([this](bool condition, clover::Ref<clover::BitVector> bv, uint32_t pc, bool needResult) {
+		return forward(condition, bv, pc, needResult);
+	});
+}
+
+bool
+Checkpoint::forward(bool condition, clover::Ref<clover::BitVector> bv, uint32_t pc, bool needResult)
+{
+	std::ostringstream stream;
+
+	stream.put(MSG_BRANCH);
+	writeInt<uint8_t>(stream, condition);
+	writeInt<uint32_t>(stream, pc);
+	writeInt<uint8_t>(stream, needResult);
+	writer->write(stream, bv);
+	sendMsg(runnerfd, stream.str());
+
+	if (!needResult)
+		return false;
+
+	uint8_t added;
+	if (!readAll(runnerfd, &added, sizeof(added)))
+		_exit(EXIT_FAILURE);
+	return added;
+}
+
+std::unique_ptr<Checkpoint::Runner>
+Checkpoint::start(clover::ConcreteStore store)
+{
+	int fds[2];
+
+	assert(available());
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+		throw std::system_error(errno, std::generic_category());
+
+	flushAll();
+	sendFd(ctrlfd, fds[1]);
+	close(fds[1]);
+
+	auto runner = std::make_unique<Runner>(fds[0], sctx.solver);
+
+	std::ostringstream req;
+	clover::TestCase::toFile(store, req);
+	sendMsg(runner->fd, req.str());
+
+	return runner;
+}
+
+std::optional<Checkpoint::Result>
+Checkpoint::process(Runner &runner)
+{
+	auto msg = recvMsg(runner.fd);
+	if (!msg.has_value())
+		throw std::runtime_error("runner process terminated unexpectedly");
+
+	std::istringstream stream(*msg);
+	switch (stream.get()) {
+	case MSG_BRANCH: {
+		bool condition = readInt<uint8_t>(stream);
+		uint32_t pc = readInt<uint32_t>(stream);
+		bool needResult = readInt<uint8_t>(stream);
+		auto bv = runner.reader.read(stream);
+
+		uint8_t added = sctx.trace.extend(runner.cursor, condition, bv, pc);
+		if (needResult)
+			writeAll(runner.fd, &added, sizeof(added));
+		return std::nullopt;
+	}
+	case MSG_TESTCASE: {
+		auto kind = (TestCaseKind)readInt<uint8_t>(stream);
+		onTestCase(kind, clover::TestCase::fromFile("runner", stream));
+		return std::nullopt;
+	}
+	case MSG_RESULT: {
+		Result result;
+		result.ret = readInt<int32_t>(stream);
+		result.stopped = readInt<uint8_t>(stream);
+		result.cursor = runner.cursor;
+		sctx.concrete_evals.add(readInt<uint64_t>(stream));
+		return result;
+	}
+	default:
+		throw std::runtime_error("invalid message from runner process");
+	}
+}
+
+Checkpoint::Result
+Checkpoint::run(clover::ConcreteStore store)
+{
+	auto runner = start(store);
+
+	for (;;) {
+		auto result = process(*runner);
+		if (result.has_value())
+			return *result;
+	}
+}
+
+void
+Checkpoint::report(TestCaseKind kind, clover::ConcreteStore store)
+{
+	assert(isRunner());
+
+	std::ostringstream stream;
+	stream.put(MSG_TESTCASE);
+	writeInt<uint8_t>(stream, kind);
+	clover::TestCase::toFile(store, stream);
+	sendMsg(runnerfd, stream.str());
+}
+
+void
+Checkpoint::finish(Result result)
+{
+	assert(isRunner());
+	flushAll();
+
+	std::ostringstream stream;
+	stream.put(MSG_RESULT);
+	writeInt<int32_t>(stream, result.ret);
+	writeInt<uint8_t>(stream, result.stopped);
+	writeInt<uint64_t>(stream, sctx.concrete_evals.get() - evals_base);
+	sendMsg(runnerfd, stream.str());
+
+	// Don't run atexit handlers and destructors of the explorer.
+	_exit(EXIT_SUCCESS);
+}
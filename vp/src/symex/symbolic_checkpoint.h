@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_ISA_SYMBOLIC_CHECKPOINT_H
+#define RISCV_ISA_SYMBOLIC_CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <clover/clover.h>
+#include "symbolic_context.h"
+
+/* Process-based checkpoint of the entire simulation state.
+ *
+ * Until the first symbolic value is created, the execution of the
+ * software does not depend on the concrete store. The checkpoint is
+ * therefore created at this point by forking a server process which
+ * retains the current state of the SystemC kernel, all modules, and
+ * the ISS. Each subsequent execution is performed in a runner process
+ * forked from this server process. This avoids re-elaborating the
+ * SystemC model and re-executing the input-independent prefix (e.g.
+ * the boot code) for each explored path.
+ *
+ * The execution tree remains in the explorer process, runner processes
+ * forward the path conditions of their execution to the explorer.
+ * Since runners are independent processes, several of them can be
+ * active at the same time to explore paths in parallel.
+ *
+ * If path conditions are not needed by the explorer (e.g. when only
+ * replaying test cases), forwarding them can be disabled. */
+class Checkpoint {
+public:
+	/* Outcome of an execution in a runner process. */
+	struct Result {
+		int ret;
+		bool stopped;
+
+		// Position of the executed path in the execution tree,
+		// only set by Checkpoint::process() in the explorer.
+		clover::Trace::Cursor cursor = nullptr;
+	};
+
+	/* Test cases reported by runners, see Checkpoint::report(). */
+	enum TestCaseKind : uint8_t {
+		TESTCASE_ERROR,
+		TESTCASE_TIMEOUT,
+	};
+
+	/* Invoked in the explorer for each test case found by a runner. */
+	typedef std::function<void(TestCaseKind, clover::ConcreteStore)> TestCaseHandler;
+
+	/* Explorer side of the connection to a runner process. */
+	class Runner {
+	private:
+		int fd;
+		clover::ExprReader reader;
+		clover::Trace::Cursor cursor = nullptr;
+
+		friend class Checkpoint;
+
+	public:
+		Runner(int _fd, clover::Solver &solver);
+		~Runner(void);
+
+		/* File descriptor which becomes readable when the runner
+		 * has sent a new message, see Checkpoint::process(). */
+		int getFd(void);
+	};
+
+private:
+	SymbolicContext &sctx;
+	TestCaseHandler onTestCase;
+	bool tracing;
+
+	pid_t server = -1;
+	int ctrlfd = -1;
+
+	// Connection to the explorer, only valid in runner processes.
+	int runnerfd = -1;
+	std::optional<clover::ExprWriter> writer;
+
+	// Concrete evaluations inherited from the explorer, only the
+	// evaluations performed by the runner itself are reported.
+	uint64_t evals_base = 0;
+
+	int serve(int fd);
+	void setupRunner(int fd);
+	bool forward(bool condition, clover::Ref<clover::BitVector> bv, uint32_t pc, bool needResult);
+
+public:
+	Checkpoint(SymbolicContext &_sctx, TestCaseHandler _onTestCase, bool _tracing = true);
+	~Checkpoint(void);
+
+	bool available(void);
+	bool isRunner(void);
+
+	/* Create the checkpoint. Returns false in the explorer process and
+	 * true in a runner process. In the latter case, the runner has
+	 * already received the concrete store for its execution. */
+	bool create(void);
+
+	/* Start an execution with the given store in a new runner process.
+	 * Multiple runners can be active at the same time. */
+	std::unique_ptr<Runner> start(clover::ConcreteStore store);
+
+	/* Process a single message from the given runner, adding received
+	 * path conditions to the execution tree. Blocks until a message is
+	 * available. Returns the result once the runner finished. */
+	std::optional<Result> process(Runner &runner);
+
+	/* Perform an execution with the given store in a new runner process
+	 * and wait for it to finish. */
+	Result run(clover::ConcreteStore store);
+
+	/* Report a test case (e.g. an error) found during the execution of
+	 * a runner process to the explorer process. */
+	void report(TestCaseKind kind, clover::ConcreteStore store);
+
+	/* Report the result of a runner process to the explorer process
+	 * and terminate the runner process. */
+	[[noreturn]] void finish(Result result);
+};
+
+#endif
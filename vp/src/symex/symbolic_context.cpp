@@ -21,6 +21,15 @@
 #include "symbolic_explore.h"
 
 #define TIMEOUT_ENV "SYMEX_TIMEOUT"
+#define STRATEGY_ENV "SYMEX_STRATEGY"
+#define MAXINSTR_ENV "SYMEX_MAXINSTR"
+#define MAXSIMTIME_ENV "SYMEX_MAXSIMTIME"
+#define MAXWALLTIME_ENV "SYMEX_MAXWALLTIME"
+#define SITEBUDGET_ENV "SYMEX_SITEBUDGET"
+#define SITEDECAY_ENV "SYMEX_SITEDECAY"
+#define INCREMENTAL_ENV "SYMEX_INCREMENTAL"
+#define QUERYCACHE_ENV "SYMEX_QUERYCACHE"
+#define PORTFOLIO_ENV "SYMEX_PORTFOLIO"
 
 // We need to pass the SymbolicContext which includes the solver,
 // tracer, … to the sc_main method somehow. This cannot be done using
@@ -28,19 +37,84 @@
 // instead.
 SymbolicContext symbolic_context = SymbolicContext();
 
+static klee::Solver *
+createCoreSolver(void)
+{
+	// Incremental solving keeps the constraints of the previous query
+	// asserted, this speeds up negating branches of long paths.
+	bool incremental = getenv(INCREMENTAL_ENV) != NULL;
+
+	// A portfolio of differently configured solvers reduces the tail
+	// latency of queries which are hard for a single configuration.
+	char *portfolio = getenv(PORTFOLIO_ENV);
+	if (portfolio)
+		return klee::createZ3PortfolioSolver(std::stoul(portfolio), incremental);
+
+	if (incremental)
+		return klee::createCoreSolver(klee::CoreSolverType::Z3_SOLVER, true);
+	return NULL; // default core solver
+}
+
 SymbolicContext::SymbolicContext(void)
-	: solver(), trace(solver), ctx(solver)
+	: solver(createCoreSolver()), trace(solver), ctx(solver)
 {
-	char *tm;
+	char *tm, *strategy, *limit, *budget, *decay, *cache;
 
 	if ((tm = getenv(TIMEOUT_ENV))) {
 		auto timeout = klee::time::Span(tm);
 		solver.setTimeout(timeout);
 	}
+	if ((cache = getenv(QUERYCACHE_ENV)))
+		solver.setQueryCache(cache);
+
+	if ((strategy = getenv(STRATEGY_ENV)))
+		trace.setStrategy(clover::SearchStrategy::create(strategy));
+	if ((budget = getenv(SITEBUDGET_ENV))) {
+		decay = getenv(SITEDECAY_ENV);
+		trace.getSites().setBudget(std::stoull(budget), (decay) ? std::stod(decay) : 1.0);
+	}
+
+	if ((limit = getenv(MAXINSTR_ENV)))
+		limits.instructions = std::stoull(limit);
+	if ((limit = getenv(MAXSIMTIME_ENV)))
+		limits.simtime = klee::time::Span(limit);
+	if ((limit = getenv(MAXWALLTIME_ENV)))
+		limits.walltime = klee::time::Span(limit);
+}
+
+void
+PathLimits::start(void)
+{
+	start_time = std::chrono::steady_clock::now();
+}
+
+void
+PathLimits::check(double simtime_seconds)
+{
+	if (simtime && simtime_seconds >= simtime.toSeconds())
+		exceeded("simulation time limit");
+
+	if (walltime) {
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+		if (elapsed.count() >= walltime.toSeconds())
+			exceeded("wall time limit");
+	}
+}
+
+void
+PathLimits::exceeded(const char *limit)
+{
+	symbolic_exploration::stop_timeout(limit);
+}
+
+uint64_t
+ConcreteEvals::get(void)
+{
+	return count;
 }
 
 void
-SymbolicContext::assume(std::shared_ptr<clover::BitVector> constraint)
+SymbolicContext::assume(clover::Ref<clover::BitVector> constraint)
 {
 	try {
 		trace.assume(constraint);
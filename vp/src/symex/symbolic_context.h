@@ -18,16 +18,70 @@
 #ifndef RISCV_ISA_SYMBOLIC_CTX_H
 #define RISCV_ISA_SYMBOLIC_CTX_H
 
+#include <stdint.h>
+
+#include <chrono>
+
 #include <clover/clover.h>
+#include <klee/System/Time.h>
+#include "symbolic_coverage.h"
+
+/* Limits for the execution of a single path. A path which exceeds any
+ * of them is terminated and reported as a timeout, see
+ * symbolic_exploration::stop_timeout(). Unset limits are zero. */
+class PathLimits {
+private:
+	std::chrono::steady_clock::time_point start_time;
+
+public:
+	uint64_t instructions = 0;
+	klee::time::Span simtime;
+	klee::time::Span walltime;
+
+	/* Begin measuring the wall time of a new path. */
+	void start(void);
+
+	/* Check the time limits, the simulation time must be passed since
+	 * SystemC is not available here. Called periodically by the ISS. */
+	void check(double simtime_seconds);
+
+	inline void check_instructions(uint64_t retired)
+	{
+		if (retired == instructions)
+			exceeded("instruction limit");
+	}
+
+	void exceeded(const char *limit);
+};
+
+/* Number of branch conditions evaluated by the ISS without invoking
+ * the solver, i.e. conditions on concrete values. The counter is local
+ * to each process, runner processes forked from a checkpoint report
+ * their count to the explorer along with their result. */
+class ConcreteEvals {
+private:
+	uint64_t count = 0;
+
+public:
+	inline void add(uint64_t n = 1)
+	{
+		count += n;
+	}
+
+	uint64_t get(void);
+};
 
 class SymbolicContext {
 public:
 	clover::Solver solver;
 	clover::Trace trace;
 	clover::ExecutionContext ctx;
+	Coverage coverage;
+	PathLimits limits;
+	ConcreteEvals concrete_evals;
 
 	SymbolicContext(void);
-	void assume(std::shared_ptr<clover::BitVector> constraint);
+	void assume(clover::Ref<clover::BitVector> constraint);
 };
 
 extern SymbolicContext symbolic_context;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#include "core/common/instr.h"
+#include "symbolic_coverage.h"
+
+static uint8_t *
+alloc_shared(size_t len)
+{
+	void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		throw std::system_error(errno, std::generic_category());
+
+	return (uint8_t *)p;
+}
+
+static bool
+is_branch(Opcode::Mapping op)
+{
+	return op >= Opcode::BEQ && op <= Opcode::BGEU;
+}
+
+Coverage::~Coverage(void)
+{
+	if (!executed)
+		return;
+
+	munmap(executed, slots);
+	munmap(taken, slots);
+	munmap(not_taken, slots);
+}
+
+void
+Coverage::init(uint32_t base, std::vector<uint8_t> _text, std::vector<Function> _functions)
+{
+	if (executed) {
+		assert(base == text_base && _text.size() / 2 == slots);
+		return;
+	}
+
+	text_base = base;
+	text = _text;
+	functions = _functions;
+	slots = text.size() / 2;
+	if (slots == 0)
+		return;
+
+	executed = alloc_shared(slots);
+	taken = alloc_shared(slots);
+	not_taken = alloc_shared(slots);
+}
+
+/* Linear sweep over the instructions in the given address range.
+ * Halfwords which do not decode to a valid instruction are skipped. */
+Coverage::Stats
+Coverage::collect(uint32_t start, uint32_t end, std::ostream *out)
+{
+	Stats stats;
+
+	start = std::max(start, text_base);
+	end = std::min(end, (uint32_t)(text_base + slots * 2));
+	for (uint32_t addr = start & ~1; addr < end;) {
+		size_t off = addr - text_base;
+		uint32_t word = 0;
+		memcpy(&word, &text[off], std::min((size_t)4, text.size() - off));
+
+		Instruction instr(word);
+		Opcode::Mapping op;
+		uint32_t len;
+		if (instr.is_compressed()) {
+			op = instr.decode_and_expand_compressed(RV32);
+			len = 2;
+		} else {
+			op = instr.decode_normal(RV32);
+			len = 4;
+		}
+
+		if (op == Opcode::UNDEF) {
+			addr += 2;
+			continue;
+		}
+
+		size_t idx = off / 2;
+		stats.instrs++;
+		stats.instrs_covered += executed[idx];
+		if (is_branch(op)) {
+			stats.edges += 2;
+			stats.edges_covered += taken[idx] + not_taken[idx];
+		}
+
+		if (out) {
+			*out << (is_branch(op) ? "branch " : "instr ") << std::hex << "0x" << addr << std::dec
+				<< " " << +executed[idx];
+			if (is_branch(op))
+				*out << " " << +taken[idx] << " " << +not_taken[idx];
+			*out << std::endl;
+		}
+
+		addr += len;
+	}
+
+	return stats;
+}
+
+static std::string
+percent(size_t covered, size_t total)
+{
+	std::ostringstream stream;
+
+	stream << covered << "/" << total;
+	if (total > 0)
+		stream << " (" << std::fixed << std::setprecision(1) << (100.0 * covered / total) << "%)";
+	return stream.str();
+}
+
+void
+Coverage::report(std::ostream &stream, bool perFunction)
+{
+	if (!enabled())
+		return;
+
+	if (perFunction) {
+		for (auto &func : functions) {
+			auto stats = collect(func.addr, func.addr + func.size, nullptr);
+			stream << func.name << ": instructions " << percent(stats.instrs_covered, stats.instrs)
+				<< ", branches " << percent(stats.edges_covered, stats.edges) << std::endl;
+		}
+	}
+
+	auto stats = collect(text_base, text_base + slots * 2, nullptr);
+	stream << "Instruction coverage: " << percent(stats.instrs_covered, stats.instrs) << std::endl;
+	stream << "Branch coverage: " << percent(stats.edges_covered, stats.edges) << std::endl;
+}
+
+void
+Coverage::save(std::string path)
+{
+	if (!enabled())
+		return;
+
+	std::ofstream file(path);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + path);
+
+	for (auto &func : functions) {
+		file << "function " << func.name << std::hex << " 0x" << func.addr
+			<< std::dec << " " << func.size << std::endl;
+	}
+	collect(text_base, text_base + slots * 2, &file);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020,2021 Group of Computer Architecture, University of Bremen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RISCV_ISA_SYMBOLIC_COVERAGE_H
+#define RISCV_ISA_SYMBOLIC_COVERAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Instruction and branch coverage of the executed software.
+ *
+ * Coverage is recorded in flat maps with one byte per halfword of the
+ * executable segments, indexed by (pc - text_base) / 2. Recording an
+ * executed instruction is thus a single store. The maps reside in
+ * shared memory and therefore accumulate the coverage of all
+ * executions, including those performed in forked runner processes.
+ * Since bytes are only ever set to 1, concurrent updates don't race. */
+class Coverage {
+public:
+	struct Function {
+		std::string name;
+		uint32_t addr;
+		uint32_t size;
+	};
+
+private:
+	uint32_t text_base = 0;
+	size_t slots = 0;
+
+	uint8_t *executed = nullptr;
+	uint8_t *taken = nullptr;
+	uint8_t *not_taken = nullptr;
+
+	// Contents of the executable segments, used to determine the
+	// instructions (and the branches among them) for the report.
+	std::vector<uint8_t> text;
+	std::vector<Function> functions;
+
+	struct Stats {
+		size_t instrs = 0, instrs_covered = 0;
+		size_t edges = 0, edges_covered = 0;
+	};
+
+	Stats collect(uint32_t start, uint32_t end, std::ostream *out);
+
+public:
+	~Coverage(void);
+
+	/* Initialize coverage for the given text segment. Subsequent calls
+	 * (e.g. from re-elaborated simulations) retain recorded coverage. */
+	void init(uint32_t base, std::vector<uint8_t> text, std::vector<Function> functions);
+
+	template <typename Loader>
+	void init(Loader &loader);
+
+	bool enabled(void)
+	{
+		return executed != nullptr;
+	}
+
+	// Bytes are only written if not set yet. Otherwise, runners
+	// executing the same code would continuously invalidate each
+	// other's copies of the shared cache lines.
+	inline void visit(uint32_t pc)
+	{
+		size_t idx = (pc - text_base) / 2;
+		if (idx < slots && !executed[idx])
+			executed[idx] = 1;
+	}
+
+	inline void branch(uint32_t pc, bool cond)
+	{
+		size_t idx = (pc - text_base) / 2;
+		uint8_t *map = (cond) ? taken : not_taken;
+		if (idx < slots && !map[idx])
+			map[idx] = 1;
+	}
+
+	/* Print instruction and branch coverage, optionally per function. */
+	void report(std::ostream &stream, bool perFunction = false);
+
+	/* Write the coverage of each instruction in a line-based format:
+	 *
+	 *   instr <addr> <executed>
+	 *   branch <addr> <executed> <taken> <not-taken>
+	 *   function <name> <addr> <size>
+	 *
+	 * Addresses are hexadecimal and can be mapped to source lines
+	 * using addr2line(1). */
+	void save(std::string path);
+};
+
+template <typename Loader>
+void
+Coverage::init(Loader &loader)
+{
+	const char *elf = loader.elf.data();
+	uint32_t start = UINT32_MAX, end = 0;
+
+	// Executable segments are merged into a single text region.
+	auto sections = loader.get_load_sections();
+	for (auto p : sections) {
+		if (!(p->p_flags & 1)) // PF_X
+			continue;
+
+		start = std::min(start, (uint32_t)p->p_vaddr);
+		end = std::max(end, (uint32_t)(p->p_vaddr + p->p_filesz));
+	}
+	if (start >= end)
+		return;
+
+	std::vector<uint8_t> bytes(end - start, 0);
+	for (auto p : sections) {
+		if (p->p_flags & 1)
+			std::copy(elf + p->p_offset, elf + p->p_offset + p->p_filesz, bytes.begin() + (p->p_vaddr - start));
+	}
+
+	std::vector<Function> funcs;
+	try {
+		auto symtab = loader.get_section(".symtab");
+		const char *strings = loader.get_symbol_string_table();
+
+		typedef typename Loader::Elf_Sym Sym;
+		for (size_t off = 0; off + sizeof(Sym) <= symtab->sh_size; off += sizeof(Sym)) {
+			auto sym = reinterpret_cast<const Sym *>(elf + symtab->sh_offset + off);
+			if ((sym->st_info & 0xf) == 2 && sym->st_size > 0) // STT_FUNC
+				funcs.push_back({strings + sym->st_name, sym->st_value, sym->st_size});
+		}
+	} catch (const std::runtime_error &) {
+		// Stripped executable, only report overall coverage.
+	}
+
+	init(start, bytes, funcs);
+}
+
+#endif
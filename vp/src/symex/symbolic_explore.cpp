@@ -21,11 +21,13 @@
 #include <assert.h>
 #include <errno.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdbool.h>
 #include <signal.h>
+#include <poll.h>
 
 /* Debug leaks with valgrind --leak-check=full --undef-value-errors=no
  * Also: Define valgrind here to prevent spurious Z3 memory leaks. */
@@ -33,6 +35,9 @@
 #include <z3.h>
 #endif
 
+#include <algorithm>
+#include <deque>
+#include <fstream>
 #include <iostream>
 #include <systemc>
 #include <filesystem>
@@ -41,33 +46,145 @@
 #include <clover/clover.h>
 #include "symbolic_explore.h"
 #include "symbolic_context.h"
+#include "symbolic_checkpoint.h"
+#include "symbolic_campaign.h"
+#include "symbolic_format.h"
 
 #define TESTCASE_ENV "SYMEX_TESTCASE"
 #define TIMEBUDGET_ENV "SYMEX_TIMEBUDGET"
 #define ERR_EXIT_ENV "SYMEX_ERREXIT"
+#define CHECKPOINT_ENV "SYMEX_CHECKPOINT"
+#define JOBS_ENV "SYMEX_JOBS"
+#define GENERATIONAL_ENV "SYMEX_GENERATIONAL"
+#define CAMPAIGN_ENV "SYMEX_CAMPAIGN"
+#define SEEDS_ENV "SYMEX_SEEDS"
+#define SEED_FORMAT_ENV "SYMEX_SEED_FORMAT"
+#define COVERAGE_ENV "SYMEX_COVERAGE"
+#define PIPELINE_ENV "SYMEX_PIPELINE"
+#define PROFILE_ENV "SYMEX_PROFILE"
+
+// Seconds granted to an in-flight execution after the time budget
+// was exceeded, before terminating without saving the campaign.
+#define CAMPAIGN_GRACE 10
 
 static std::filesystem::path *testcase_path = nullptr;
+static pid_t testcase_owner;
 static size_t errors_found = 0;
+static size_t timeouts_found = 0;
 static size_t paths_found = 0;
 
+static Checkpoint *checkpoint = nullptr;
+static unsigned long jobs = 1;
+
+// Maximum number of stores solved ahead while runners are simulating.
+static unsigned long pipeline = 0;
+
+// Concrete stores obtained by negating all branches of a path at once,
+// or solved ahead of time while runners were simulating.
+static std::deque<clover::ConcreteStore> worklist;
+
+// Time spent solving while simulation was waiting for the result, and
+// time spent solving ahead which overlapped with simulation.
 static std::chrono::duration<double, std::milli> solver_time;
+static std::chrono::duration<double, std::milli> pipelined_time;
+
+// State which is only tracked when exploring a persistent campaign.
+static char *campaign_file = nullptr;
+static std::vector<std::pair<std::string, clover::ConcreteStore>> testcases;
+static std::vector<clover::ConcreteStore> active;
+static volatile sig_atomic_t budget_exceeded = 0;
+
+// Solver profile, written on exit and when receiving SIGUSR1.
+static char *profile_file = nullptr;
+static volatile sig_atomic_t profile_requested = 0;
+
+// Outcome of replaying a single test case in batch replay mode.
+enum ReplayStatus {
+	REPLAY_PASS,
+	REPLAY_FAIL,
+	REPLAY_ERROR,
+};
+
+static bool replaying = false;
+static const char *replay_failure = nullptr;
+static size_t replay_counts[REPLAY_ERROR + 1];
+
+#define TOP_SITES 10
+
+static void
+report_sites(void)
+{
+	auto &sites = symbolic_context.trace.getSites();
+	auto stats = sites.getStats();
+	if (stats.empty())
+		return;
+
+	std::cout << "Most negated branch sites:" << std::endl;
+	for (size_t i = 0; i < stats.size() && i < TOP_SITES; i++) {
+		auto &site = stats[i];
+		std::cout << "  0x" << std::hex << site.first << std::dec << ": "
+		          << site.second.negations << " negations, "
+		          << site.second.paths << " new paths"
+		          << (sites.isSaturated(site.first) ? " (saturated)" : "") << std::endl;
+	}
+	std::cout << "Saturated branch sites: " << sites.countSaturated() << std::endl;
+}
+
+static void
+write_profile(void)
+{
+	std::string tmp = std::string(profile_file) + ".tmp";
+
+	std::ofstream file(tmp);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open " + tmp);
+	symbolic_context.solver.getProfile().write(file);
+	file.close();
+
+	// Replace a previously written profile atomically.
+	if (rename(tmp.c_str(), profile_file) == -1)
+		throw std::system_error(errno, std::generic_category());
+}
 
 static void
 dump_stats(void)
 {
 	auto stime = std::chrono::duration_cast<std::chrono::seconds>(solver_time);
+	auto ptime = std::chrono::duration_cast<std::chrono::seconds>(pipelined_time);
+	char *coverage_file = getenv(COVERAGE_ENV);
+
+	// Detailed coverage is only reported if a coverage file is requested.
+	if (coverage_file) {
+		std::cout << std::endl << "---" << std::endl;
+		symbolic_context.coverage.report(std::cout, true);
+		symbolic_context.coverage.save(coverage_file);
+	}
 
 	std::cout << std::endl << "---" << std::endl;
 	std::cout << "Unique paths found: " << paths_found << std::endl;
 	std::cout << "Solver Time: " << stime.count() << " seconds" << std::endl;
-	// TODO: Also dump instruction branch coverage here.
-	if (errors_found > 0) {
+	if (pipeline)
+		std::cout << "Pipelined Solver Time: " << ptime.count() << " seconds" << std::endl;
+	std::cout << "Solver calls avoided: " << symbolic_context.concrete_evals.get() << std::endl;
+	symbolic_context.coverage.report(std::cout);
+	report_sites();
+	if (coverage_file)
+		std::cout << "Coverage file: " << coverage_file << std::endl;
+	if (errors_found > 0)
 		std::cout << "Errors found: " << errors_found << std::endl;
+	if (timeouts_found > 0)
+		std::cout << "Timeouts found: " << timeouts_found << std::endl;
+	if (errors_found > 0 || timeouts_found > 0)
 		std::cout << "Testcase directory: " << *testcase_path << std::endl;
+
+	if (profile_file) {
+		write_profile();
+		std::cout << "Solver profile: " << profile_file << std::endl;
 	}
 }
 
 static const char* assume_mtype = "/AGRA/riscv-vp/assume-notification";
+static const char* timeout_mtype = "/AGRA/riscv-vp/timeout-notification";
 static bool stopped = false;
 
 void
@@ -76,14 +193,15 @@ symbolic_exploration::stop_assume(void)
 	SC_REPORT_ERROR(assume_mtype, "AssumeNotification");
 }
 
-static std::optional<std::string>
-dump_input(std::string fn)
+void
+symbolic_exploration::stop_timeout(const char *limit)
 {
-	clover::ExecutionContext &ctx = symbolic_context.ctx;
-	clover::ConcreteStore store = ctx.getPrevStore();
-	if (store.empty())
-		return std::nullopt; // Execution does not depend on symbolic values
+	SC_REPORT_ERROR(timeout_mtype, limit);
+}
 
+static std::string
+dump_input(clover::ConcreteStore store, std::string fn)
+{
 	assert(testcase_path);
 	auto path = *testcase_path / fn;
 
@@ -95,20 +213,63 @@ dump_input(std::string fn)
 	return path;
 }
 
+static void
+found_error(clover::ConcreteStore store)
+{
+	auto name = "error" + std::to_string(++errors_found);
+	auto path = dump_input(store, name);
+	if (campaign_file)
+		testcases.push_back(std::make_pair(name, store));
+
+	std::cerr << "Found error, use " << path << " to reproduce." << std::endl;
+	if (getenv(ERR_EXIT_ENV)) {
+		std::cerr << "Exit on first error set, terminating..." << std::endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void
+found_timeout(clover::ConcreteStore store)
+{
+	auto name = "timeout" + std::to_string(++timeouts_found);
+	auto path = dump_input(store, name);
+	if (campaign_file)
+		testcases.push_back(std::make_pair(name, store));
+
+	std::cerr << "Found timeout, use " << path << " to reproduce." << std::endl;
+}
+
+static void
+found_testcase(Checkpoint::TestCaseKind kind, clover::ConcreteStore store)
+{
+	if (kind == Checkpoint::TESTCASE_TIMEOUT)
+		found_timeout(store);
+	else
+		found_error(store);
+}
+
 static void
 report_handler(const sc_core::sc_report& report, const sc_core::sc_actions& actions)
 {
 	auto mtype = report.get_msg_type();
-	if (!strcmp(mtype, "/AGRA/riscv-vp/host-error") && testcase_path) {
-		auto path = dump_input("error" + std::to_string(++errors_found));
-		if (!path.has_value())
-			return;
-
-		std::cerr << "Found error, use " << *path << " to reproduce." << std::endl;
-		if (getenv(ERR_EXIT_ENV)) {
-			std::cerr << "Exit on first error set, terminating..." << std::endl;
-			exit(EXIT_FAILURE);
-		}
+	if (!strcmp(mtype, "/AGRA/riscv-vp/host-error") && replaying) {
+		// Replayed test cases fail regardless of symbolic values.
+		if (checkpoint && checkpoint->isRunner())
+			checkpoint->report(Checkpoint::TESTCASE_ERROR, symbolic_context.ctx.getPrevStore());
+		else
+			replay_failure = "error";
+
+		sc_core::sc_stop();
+	} else if (!strcmp(mtype, "/AGRA/riscv-vp/host-error") && testcase_path) {
+		clover::ConcreteStore store = symbolic_context.ctx.getPrevStore();
+		if (store.empty())
+			return; // Execution does not depend on symbolic values
+
+		// Test cases are written by the explorer, which numbers them.
+		if (checkpoint && checkpoint->isRunner())
+			checkpoint->report(Checkpoint::TESTCASE_ERROR, store);
+		else
+			found_error(store);
 
 		sc_core::sc_stop();
 	} else if (!strcmp(mtype, assume_mtype)) {
@@ -119,17 +280,129 @@ report_handler(const sc_core::sc_report& report, const sc_core::sc_actions& acti
 		if (new_actions & sc_core::SC_DISPLAY)
 			new_actions &= ~sc_core::SC_DISPLAY;
 		sc_core::sc_report_handler::default_handler(report, new_actions);
+	} else if (!strcmp(mtype, timeout_mtype)) {
+		stopped = true;
+		std::cerr << "Path exceeded " << report.get_msg() << ", terminating path..." << std::endl;
+
+		clover::ConcreteStore store = symbolic_context.ctx.getPrevStore();
+		if (checkpoint && checkpoint->isRunner() && (replaying || !store.empty()))
+			checkpoint->report(Checkpoint::TESTCASE_TIMEOUT, store);
+		else if (replaying)
+			replay_failure = "timeout";
+		else if (testcase_path && !store.empty())
+			found_timeout(store);
+
+		// Terminate the path like an assume notification.
+		sc_core::sc_actions new_actions = actions;
+		if (new_actions & sc_core::SC_DISPLAY)
+			new_actions &= ~sc_core::SC_DISPLAY;
+		sc_core::sc_report_handler::default_handler(report, new_actions);
 	} else {
 		sc_core::sc_report_handler::default_handler(report, actions);
 	}
 }
 
+static void
+save_campaign(void)
+{
+	Campaign campaign;
+
+	campaign.paths_found = paths_found;
+	campaign.solver_time = solver_time;
+	campaign.pipelined_time = pipelined_time;
+	campaign.testcases = testcases;
+
+	// Executions which did not complete are repeated on resume.
+	for (auto &store : active)
+		campaign.pending.push_back(store);
+	for (auto &store : worklist)
+		campaign.pending.push_back(store);
+
+	campaign.save(campaign_file, symbolic_context.trace);
+	std::cout << "Campaign saved to " << campaign_file << std::endl;
+}
+
+static bool
+load_campaign(void)
+{
+	Campaign campaign;
+
+	if (!campaign.load(campaign_file, symbolic_context.trace))
+		return false;
+
+	paths_found = campaign.paths_found;
+	solver_time = campaign.solver_time;
+	pipelined_time = campaign.pipelined_time;
+	worklist = campaign.pending;
+
+	// Test cases of previous invocations are written to the test
+	// case directory of this invocation, retaining their names.
+	testcases = campaign.testcases;
+	for (auto &testcase : testcases)
+		dump_input(testcase.second, testcase.first);
+	for (auto &testcase : testcases) {
+		if (testcase.first.rfind("timeout", 0) == 0)
+			timeouts_found++;
+		else
+			errors_found++;
+	}
+
+	std::cout << "Resuming campaign " << campaign_file << " with "
+		<< paths_found << " paths, " << errors_found << " errors and "
+		<< timeouts_found << " timeouts" << std::endl;
+	return true;
+}
+
+/* Terminate if the time budget was exceeded while an execution was
+ * in-flight. Must only be called while the execution tree is consistent. */
+static void
+check_budget(void)
+{
+	if (!budget_exceeded)
+		return;
+
+	std::cout << "Time budget exceeded, terminating..." << std::endl;
+
+	save_campaign();
+	dump_stats();
+	exit(EXIT_SUCCESS);
+}
+
+/* Write the solver profile if requested through SIGUSR1. Like
+ * check_budget(), this is only called between executions. */
+static void
+check_profile(void)
+{
+	if (!profile_requested)
+		return;
+
+	profile_requested = 0;
+	write_profile();
+}
+
+static void
+sigusr1_handler(int signum)
+{
+	(void)signum;
+	profile_requested = 1;
+}
+
 static void
 sigalrm_handler(int signum)
 {
 	(void)signum;
 
+	// When exploring a campaign, the execution tree must be saved in a
+	// consistent state. Let the in-flight execution complete first.
+	if (campaign_file && !budget_exceeded) {
+		budget_exceeded = 1;
+		alarm(CAMPAIGN_GRACE);
+		return;
+	}
+
 	std::cout << "Time budget exceeded, terminating..." << std::endl;
+	if (campaign_file)
+		std::cout << "Execution did not complete, campaign not saved" << std::endl;
 
 	dump_stats();
 	exit(EXIT_SUCCESS);
@@ -139,7 +412,7 @@ static void
 remove_testdir(void)
 {
 	assert(testcase_path != nullptr);
-	if (errors_found > 0)
+	if (errors_found > 0 || timeouts_found > 0 || getpid() != testcase_owner)
 		return;
 
 	// Remove test directory if no errors were found
@@ -159,71 +432,301 @@ create_testdir(void)
 	if (!(dirpath = mkdtemp(tmpl)))
 		throw std::system_error(errno, std::generic_category());
 	testcase_path = new std::filesystem::path(dirpath);
+	testcase_owner = getpid();
 
 	if (std::atexit(remove_testdir))
 		throw std::runtime_error("std::atexit failed");
 }
 
+static std::optional<clover::ConcreteStore>
+findNewStore(clover::Trace &tracer)
+{
+	if (!worklist.empty()) {
+		auto store = worklist.front();
+		worklist.pop_front();
+		return store;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto assign = tracer.findNewPath();
+	auto end = std::chrono::steady_clock::now();
+
+	solver_time += end - start;
+	if (!assign.has_value())
+		return std::nullopt;
+
+	return tracer.getStore(*assign);
+}
+
+/* Solve for the next path while runners are simulating and queue the
+ * resulting store in the worklist. Returns false if the execution tree
+ * currently contains no further path to explore. */
 static bool
-setupNewValues(clover::ExecutionContext &ctx, clover::Trace &tracer)
+solve_ahead(clover::Trace &tracer)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto assign = tracer.findNewPath();
+	auto end = std::chrono::steady_clock::now();
+
+	pipelined_time += end - start;
+	if (!assign.has_value())
+		return false;
+
+	worklist.push_back(tracer.getStore(*assign));
+	return true;
+}
+
+static void
+path_found(clover::Trace &tracer, clover::Trace::Cursor cursor)
 {
+	paths_found++;
+	if (!getenv(GENERATIONAL_ENV))
+		return;
+
 	auto start = std::chrono::steady_clock::now();
-	auto r = ctx.setupNewValues(tracer);
+	for (auto &assign : tracer.findNewPaths(cursor))
+		worklist.push_back(tracer.getStore(assign));
 	auto end = std::chrono::steady_clock::now();
 
 	solver_time += end - start;
-	return r;
 }
 
-static int
-run_test(const char *path, int argc, char **argv)
+static void
+create_checkpoint(void)
+{
+	// Only create a checkpoint during the first execution.
+	if (checkpoint->available() || checkpoint->isRunner())
+		return;
+
+	checkpoint->create();
+}
+
+static clover::ConcreteStore
+load_testcase(std::string fp)
 {
-	std::string fp(path);
 	std::ifstream file(fp);
 	if (!file.is_open())
 		throw std::runtime_error("failed to open " + fp);
 
+	return clover::TestCase::fromFile(fp, file);
+}
+
+static int
+run_test(const char *path, int argc, char **argv)
+{
 	clover::ExecutionContext &ctx = symbolic_context.ctx;
-	clover::ConcreteStore store = clover::TestCase::fromFile(fp, file);
+	clover::ConcreteStore store = load_testcase(path);
 
 	ctx.setupNewValues(store);
+	symbolic_context.limits.start();
 	return sc_core::sc_elab_and_sim(argc, argv);
 }
 
+/* Load all seeds from the given directory. Seeds are either test cases
+ * or, if SEED_FORMAT_ENV is set, raw inputs for the given input format. */
+static std::vector<clover::ConcreteStore>
+load_seeds(const char *dir)
+{
+	std::vector<std::string> files;
+	std::vector<clover::ConcreteStore> seeds;
+
+	for (auto &entry : std::filesystem::directory_iterator(dir)) {
+		if (entry.is_regular_file())
+			files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	char *format = getenv(SEED_FORMAT_ENV);
+	for (auto &fp : files) {
+		if (!format) {
+			seeds.push_back(load_testcase(fp));
+			continue;
+		}
+
+		std::ifstream file(fp, std::ios::binary);
+		if (!file.is_open())
+			throw std::runtime_error("failed to open " + fp);
+
+		std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)),
+		                           std::istreambuf_iterator<char>());
+		seeds.push_back(SymbolicFormat::toStore(format, input));
+	}
+
+	return seeds;
+}
+
 static int
-explore_paths(int argc, char **argv)
+run_path(int argc, char **argv, std::optional<clover::ConcreteStore> store, clover::Trace::Cursor &cursor)
 {
 	clover::ExecutionContext &ctx = symbolic_context.ctx;
 	clover::Trace &tracer = symbolic_context.trace;
 
+	stopped = false;
+	if (checkpoint && checkpoint->available()) {
+		assert(store.has_value());
+
+		auto result = checkpoint->run(*store);
+		stopped = result.stopped;
+		cursor = result.cursor;
+
+		return result.ret;
+	}
+
+	if (store.has_value())
+		ctx.setupNewValues(*store);
+	tracer.reset();
+
+	// Reset SystemC simulation context
+	// See also: https://github.com/accellera-official/systemc/issues/8
+	if (sc_core::sc_curr_simcontext) {
+		sc_core::sc_report_handler::release();
+		delete sc_core::sc_curr_simcontext;
+	}
+	sc_core::sc_curr_simcontext = NULL;
+
+	symbolic_context.limits.start();
+	int ret = sc_core::sc_elab_and_sim(argc, argv);
+
+	// Runner processes forked from the checkpoint return here.
+	if (checkpoint && checkpoint->isRunner())
+		checkpoint->finish({ret, stopped});
+
+	cursor = tracer.getCursor();
+	return ret;
+}
+
+static int
+explore_parallel(clover::Trace &tracer)
+{
+	std::vector<std::unique_ptr<Checkpoint::Runner>> runners;
+	std::vector<struct pollfd> fds;
+	bool exhausted = false;
+
+	for (;;) {
+		// Paths of active runners are not part of the execution tree
+		// yet. Hence, exploration only ends if no runner is active.
+		std::optional<clover::ConcreteStore> store;
+		check_budget();
+		check_profile();
+		while (runners.size() < jobs && (store = findNewStore(tracer))) {
+			runners.push_back(checkpoint->start(*store));
+			if (campaign_file)
+				active.push_back(*store);
+		}
+		if (runners.empty())
+			return 0;
+
+		fds.clear();
+		for (auto &runner : runners)
+			fds.push_back({runner->getFd(), POLLIN, 0});
+
+		// While all runners are simulating, solve for upcoming paths
+		// unless a message from a runner is already pending. Messages
+		// may extend the execution tree, i.e. add new paths to solve.
+		bool ahead = !exhausted && worklist.size() < pipeline;
+		int ready = poll(fds.data(), fds.size(), (ahead) ? 0 : -1);
+		if (ready == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		} else if (ready == 0) {
+			exhausted = !solve_ahead(tracer);
+			continue;
+		}
+		exhausted = false;
+
+		for (size_t i = fds.size(); i-- > 0;) {
+			if (!fds[i].revents)
+				continue;
+
+			auto result = checkpoint->process(*runners[i]);
+			if (!result.has_value())
+				continue;
+			runners.erase(runners.begin() + i);
+			if (campaign_file)
+				active.erase(active.begin() + i);
+
+			if (result->ret && !result->stopped)
+				return result->ret;
+			if (!result->stopped)
+				path_found(tracer, result->cursor);
+		}
+	}
+}
+
+static int
+explore_paths(int argc, char **argv)
+{
+	clover::Trace &tracer = symbolic_context.trace;
+	std::optional<clover::ConcreteStore> store;
+
 	// Set stop mode for symbolic_exploration::stop.
 	sc_core::sc_set_stop_mode(sc_core::SC_STOP_IMMEDIATE);
 
+	// A resumed campaign continues with the pending executions or
+	// the next unexplored path of the loaded execution tree.
+	bool resumed = campaign_file && load_campaign();
+	if (resumed && !(store = findNewStore(tracer))) {
+		std::cout << "Campaign already complete" << std::endl;
+		return 0;
+	}
+
+	// Seeds are executed before any branch is negated, the first seed
+	// replaces the random input of the initial execution. Seeds are not
+	// needed when resuming, the campaign already includes their paths.
+	char *seeds = getenv(SEEDS_ENV);
+	if (seeds && !resumed) {
+		for (auto &seed : load_seeds(seeds))
+			worklist.push_back(seed);
+		std::cout << "Loaded " << worklist.size() << " seeds from " << seeds << std::endl;
+		if (!worklist.empty())
+			store = findNewStore(tracer);
+	}
+
+	// Parallel and pipelined exploration require runners forked
+	// from a checkpoint.
+	if (getenv(CHECKPOINT_ENV) || jobs > 1 || pipeline) {
+		checkpoint = new Checkpoint(symbolic_context, found_testcase);
+		symbolic_context.ctx.onFirstSymbolic(create_checkpoint);
+	}
+
 	do {
+		// The next store was already removed from the execution tree.
+		if (campaign_file && store.has_value())
+			active = {*store};
+		check_budget();
+		check_profile();
+
 		if (!stopped) {
 			std::cout << std::endl << "##" << std::endl << "# "
 				<< paths_found + 1 << "th concolic execution" << std::endl
 				<< "##" << std::endl;
 		}
 
-		tracer.reset();
-
-		// Reset SystemC simulation context
-		// See also: https://github.com/accellera-official/systemc/issues/8
-		if (sc_core::sc_curr_simcontext) {
-			sc_core::sc_report_handler::release();
-			delete sc_core::sc_curr_simcontext;
-		}
-		sc_core::sc_curr_simcontext = NULL;
-
 		int ret;
-		stopped = false;
-		if ((ret = sc_core::sc_elab_and_sim(argc, argv)) && !stopped)
+		clover::Trace::Cursor cursor;
+		if ((ret = run_path(argc, argv, store, cursor)) && !stopped)
 			return ret;
+		active.clear();
 
 		if (!stopped)
-			paths_found++;
-	} while (setupNewValues(ctx, tracer));
+			path_found(tracer, cursor);
+
+		// The first execution creates the checkpoint, remaining
+		// paths can then be explored by multiple runners at once,
+		// while the next paths are solved for in this process.
+		if ((jobs > 1 || pipeline) && checkpoint->available()) {
+			if ((ret = explore_parallel(tracer)))
+				return ret;
+			break;
+		}
+	} while ((store = findNewStore(tracer)));
+
+	if (campaign_file)
+		save_campaign();
+
+	delete checkpoint;
+	checkpoint = nullptr;
 
 	sc_core::sc_report_handler::release();
 	delete sc_core::sc_curr_simcontext;
@@ -231,6 +734,180 @@ explore_paths(int argc, char **argv)
 	return 0;
 }
 
+static void
+replay_report(std::string fp, ReplayStatus status, std::string msg = "")
+{
+	static const char *names[] = {"PASS", "FAIL", "ERROR"};
+
+	replay_counts[status]++;
+	std::cout << names[status] << ": " << fp;
+	if (!msg.empty())
+		std::cout << " (" << msg << ")";
+	std::cout << std::endl;
+}
+
+static void
+replay_result(std::string fp, int ret, bool stopped, const char *failure)
+{
+	if (ret && !stopped)
+		replay_report(fp, REPLAY_ERROR, "exit status " + std::to_string(ret));
+	else if (failure)
+		replay_report(fp, REPLAY_FAIL, failure);
+	else
+		replay_report(fp, REPLAY_PASS);
+}
+
+static void
+replay_local(std::string fp, int argc, char **argv)
+{
+	clover::ConcreteStore store;
+
+	try {
+		store = load_testcase(fp);
+	} catch (const std::exception &e) {
+		replay_report(fp, REPLAY_ERROR, e.what());
+		return;
+	}
+
+	clover::Trace::Cursor cursor;
+	replay_failure = nullptr;
+	int ret = run_path(argc, argv, store, cursor);
+
+	replay_result(fp, ret, stopped, replay_failure);
+}
+
+/* Replay all test cases in the given directory. The first replay
+ * creates a checkpoint once the first symbolic value is requested,
+ * all remaining test cases are replayed in runners forked from it.
+ * Hence, the ELF file is only loaded and the input format is only
+ * parsed once. Path conditions are not forwarded to the explorer. */
+static int
+replay_tests(const char *dir, int argc, char **argv)
+{
+	struct Replay {
+		std::string fp;
+		std::unique_ptr<Checkpoint::Runner> runner;
+		const char *failure;
+	};
+
+	std::vector<std::string> files;
+	for (auto &entry : std::filesystem::directory_iterator(dir)) {
+		if (entry.is_regular_file())
+			files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+
+	replaying = true;
+	sc_core::sc_report_handler::set_handler(report_handler);
+	sc_core::sc_set_stop_mode(sc_core::SC_STOP_IMMEDIATE);
+
+	checkpoint = new Checkpoint(symbolic_context, [](Checkpoint::TestCaseKind kind, clover::ConcreteStore) {
+		replay_failure = (kind == Checkpoint::TESTCASE_TIMEOUT) ? "timeout" : "error";
+	}, false);
+	symbolic_context.ctx.onFirstSymbolic(create_checkpoint);
+
+	std::vector<Replay> replays;
+	std::vector<struct pollfd> fds;
+	size_t next = 0;
+
+	while (next < files.size() || !replays.empty()) {
+		// Replay locally until the checkpoint has been created, this
+		// is the case if the software never requested symbolic values.
+		if (!checkpoint->available()) {
+			replay_local(files[next++], argc, argv);
+			continue;
+		}
+
+		while (replays.size() < jobs && next < files.size()) {
+			auto fp = files[next++];
+			try {
+				replays.push_back({fp, checkpoint->start(load_testcase(fp)), nullptr});
+			} catch (const std::exception &e) {
+				replay_report(fp, REPLAY_ERROR, e.what());
+			}
+		}
+		if (replays.empty())
+			continue;
+
+		fds.clear();
+		for (auto &replay : replays)
+			fds.push_back({replay.runner->getFd(), POLLIN, 0});
+
+		if (poll(fds.data(), fds.size(), -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		}
+
+		for (size_t i = fds.size(); i-- > 0;) {
+			if (!fds[i].revents)
+				continue;
+
+			auto &replay = replays[i];
+			std::optional<Checkpoint::Result> result;
+			try {
+				replay_failure = nullptr;
+				result = checkpoint->process(*replay.runner);
+				if (replay_failure)
+					replay.failure = replay_failure;
+			} catch (const std::exception &e) {
+				replay_report(replay.fp, REPLAY_ERROR, e.what());
+				replays.erase(replays.begin() + i);
+				continue;
+			}
+
+			if (result.has_value()) {
+				replay_result(replay.fp, result->ret, result->stopped, replay.failure);
+				replays.erase(replays.begin() + i);
+			}
+		}
+	}
+
+	delete checkpoint;
+	checkpoint = nullptr;
+
+	sc_core::sc_report_handler::release();
+	delete sc_core::sc_curr_simcontext;
+
+	std::cout << std::endl << "---" << std::endl;
+	std::cout << "Test cases replayed: " << files.size() << std::endl;
+	std::cout << "Passed: " << replay_counts[REPLAY_PASS] << std::endl;
+	std::cout << "Failed: " << replay_counts[REPLAY_FAIL] << std::endl;
+	std::cout << "Errors: " << replay_counts[REPLAY_ERROR] << std::endl;
+
+	if (replay_counts[REPLAY_FAIL] || replay_counts[REPLAY_ERROR])
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+static void
+setup_jobs(void)
+{
+	char *njobs = getenv(JOBS_ENV);
+	if (!njobs)
+		return;
+
+	errno = 0;
+	jobs = strtoul(njobs, NULL, 10);
+	if (!jobs && errno)
+		throw std::system_error(errno, std::generic_category());
+	if (!jobs)
+		throw std::invalid_argument(JOBS_ENV " must be at least 1");
+}
+
+static void
+setup_pipeline(void)
+{
+	char *depth = getenv(PIPELINE_ENV);
+	if (!depth)
+		return;
+
+	errno = 0;
+	pipeline = strtoul(depth, NULL, 10);
+	if (!pipeline && errno)
+		throw std::system_error(errno, std::generic_category());
+}
+
 static void
 setup_timeout(void)
 {
@@ -257,6 +934,24 @@ setup_timeout(void)
 	(void)r;
 }
 
+static void
+setup_profile(void)
+{
+	struct sigaction sa;
+
+	profile_file = getenv(PROFILE_ENV);
+	if (!profile_file)
+		return;
+	symbolic_context.solver.getProfile().enable();
+
+	sa.sa_flags = SA_RESTART;
+	sa.sa_handler = sigusr1_handler;
+	if (sigemptyset(&sa.sa_mask) == -1)
+		throw std::system_error(errno, std::generic_category());
+	if (sigaction(SIGUSR1, &sa, NULL) == -1)
+		throw std::system_error(errno, std::generic_category());
+}
+
 int
 symbolic_explore(int argc, char **argv)
 {
@@ -269,15 +964,21 @@ symbolic_explore(int argc, char **argv)
 	// Use current time as seed for random generator
 	std::srand(std::time(nullptr));
 
+	setup_jobs();
+	setup_pipeline();
 	char *testcase = getenv(TESTCASE_ENV);
-	if (testcase)
+	if (testcase && std::filesystem::is_directory(testcase))
+		return replay_tests(testcase, argc, argv);
+	else if (testcase)
 		return run_test(testcase, argc, argv);
 	create_testdir();
 
 	// Set report handler for detecting errors
 	sc_core::sc_report_handler::set_handler(report_handler);
 
+	campaign_file = getenv(CAMPAIGN_ENV);
 	setup_timeout();
+	setup_profile();
 	int ret = explore_paths(argc, argv);
 	dump_stats();
 
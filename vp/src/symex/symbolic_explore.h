@@ -24,6 +24,7 @@ int symbolic_explore(int argc, char **argv);
 
 namespace symbolic_exploration {
 	void stop_assume(void);
+	void stop_timeout(const char *limit);
 };
 
 #endif
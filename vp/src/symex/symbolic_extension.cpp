@@ -17,7 +17,7 @@
 
 #include "symbolic_extension.h"
 
-SymbolicExtension::SymbolicExtension(std::shared_ptr<clover::ConcolicValue> _value)
+SymbolicExtension::SymbolicExtension(clover::Ref<clover::ConcolicValue> _value)
 {
 	value = _value;
 }
@@ -39,7 +39,7 @@ SymbolicExtension::clone(void) const
 	return new SymbolicExtension(*this);
 }
 
-std::shared_ptr<clover::ConcolicValue>
+clover::Ref<clover::ConcolicValue>
 SymbolicExtension::getValue(void)
 {
 	return value;
@@ -29,18 +29,18 @@
 // stored in this extension, must also always be copied to the data
 // pointer of the utilized TLM-2.0 generic payload during write commands.
 class SymbolicExtension : public tlm::tlm_extension<SymbolicExtension> {
-	std::shared_ptr<clover::ConcolicValue> value;
+	clover::Ref<clover::ConcolicValue> value;
 
 public:
 	typedef tlm::tlm_base_protocol_types::tlm_payload_type tlm_payload_type;
 	typedef tlm::tlm_base_protocol_types::tlm_phase_type tlm_phase_type;
 
-	SymbolicExtension(std::shared_ptr<clover::ConcolicValue> _value);
+	SymbolicExtension(clover::Ref<clover::ConcolicValue> _value);
 	~SymbolicExtension(void);
 
 	void copy_from(const tlm_extension_base &extension);
 	tlm::tlm_extension_base *clone(void) const;
-	std::shared_ptr<clover::ConcolicValue> getValue(void);
+	clover::Ref<clover::ConcolicValue> getValue(void);
 };
 
 #endif
@@ -15,6 +15,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <map>
 #include <vector>
 #include <exception>
 #include <iostream>
@@ -107,7 +108,7 @@ SymbolicFormat::~SymbolicFormat(void)
 		err(EXIT_FAILURE, "munmap failed");
 }
 
-std::shared_ptr<clover::ConcolicValue>
+clover::Ref<clover::ConcolicValue>
 SymbolicFormat::make_symbolic(std::string name, uint64_t bitsize, size_t bytesize)
 {
 	auto symbolic_value = ctx.getSymbolicBytes(name, bytesize);
@@ -154,14 +155,14 @@ SymbolicFormat::get_name(bencode_t *list_elem)
 	return ret;
 }
 
-std::optional<std::shared_ptr<clover::ConcolicValue>>
+std::optional<clover::Ref<clover::ConcolicValue>>
 SymbolicFormat::get_value(bencode_t *list_elem, std::string name, uint64_t bitsize)
 {
 	size_t bytesize;
 	bencode_t value_elem;
 	int is_symbolic;
 	std::vector<uint8_t> concrete_value;
-	std::shared_ptr<clover::ConcolicValue> symbolic_value;
+	clover::Ref<clover::ConcolicValue> symbolic_value;
 
 	if (bencode_list_get_next(list_elem, &value_elem) != 1)
 		return std::nullopt;
@@ -225,13 +226,13 @@ SymbolicFormat::get_value(bencode_t *list_elem, std::string name, uint64_t bitsi
 	}
 }
 
-std::shared_ptr<clover::ConcolicValue>
+clover::Ref<clover::ConcolicValue>
 SymbolicFormat::next_field(void)
 {
 	bencode_t field_value;
 	long int bitsize;
 	std::string name;
-	std::shared_ptr<clover::ConcolicValue> value;
+	clover::Ref<clover::ConcolicValue> value;
 
 	if (!bencode_list_has_next(&bencode))
 		return nullptr;
@@ -258,10 +259,10 @@ SymbolicFormat::next_field(void)
 	return value;
 }
 
-std::shared_ptr<clover::ConcolicValue>
+clover::Ref<clover::ConcolicValue>
 SymbolicFormat::get_input(void)
 {
-	std::shared_ptr<clover::ConcolicValue> field, r = nullptr;
+	clover::Ref<clover::ConcolicValue> field, r = nullptr;
 
 	while ((field = next_field())) {
 		if (!r) {
@@ -277,7 +278,7 @@ SymbolicFormat::get_input(void)
 	return r;
 }
 
-std::shared_ptr<clover::ConcolicValue>
+clover::Ref<clover::ConcolicValue>
 SymbolicFormat::next_byte(void)
 {
 	if (!input_str || offset == 0)
@@ -303,3 +304,96 @@ SymbolicFormat::remaning_bytes(void)
 
 	return (width - (width - offset)) / CHAR_BIT;
 }
+
+clover::ConcreteStore
+SymbolicFormat::toStore(std::string path, const std::vector<uint8_t> &input)
+{
+	struct Field {
+		std::string name;
+		uint64_t bitsize;
+		bool is_symbolic;
+	};
+
+	const char *str;
+	ssize_t len;
+	bencode_t fields;
+	std::vector<Field> layout;
+	uint64_t width = 0;
+
+	if ((len = readfile(&str, path.c_str())) == -1)
+		throw std::system_error(errno, std::generic_category());
+	if (len == 0)
+		return clover::ConcreteStore();
+
+	assert(len <= INT_MAX);
+	bencode_init(&fields, str, (int)len);
+
+	bool valid = true;
+	while (valid && bencode_list_has_next(&fields)) {
+		bencode_t field_value, value_elem, list_elem;
+
+		if (bencode_list_get_next(&fields, &field_value) != 1 || !bencode_is_list(&field_value)) {
+			valid = false;
+			break;
+		}
+
+		auto name = get_name(&field_value);
+		auto bitsize = get_size(&field_value);
+		if (!name.has_value() || !bitsize.has_value() || *bitsize <= 0) {
+			valid = false;
+			break;
+		}
+		if (bencode_list_get_next(&field_value, &value_elem) != 1 || !bencode_is_list(&value_elem)) {
+			valid = false;
+			break;
+		}
+
+		// Same distinction between symbolic and concrete as in get_value().
+		bool is_symbolic = true;
+		if (bencode_list_has_next(&value_elem)) {
+			if (bencode_list_get_next(&value_elem, &list_elem) != 1) {
+				valid = false;
+				break;
+			}
+			is_symbolic = bencode_is_string(&list_elem);
+		}
+
+		layout.push_back({*name, (uint64_t)*bitsize, is_symbolic});
+		width += *bitsize;
+	}
+
+	if (munmap((void *)str, len) == -1)
+		err(EXIT_FAILURE, "munmap failed");
+	if (!valid)
+		throw std::invalid_argument("invalid bencode input format");
+	if (width % CHAR_BIT != 0)
+		throw std::invalid_argument("input format is not byte aligned");
+
+	// The first field occupies the most significant bits of the input,
+	// next_byte() returns the most significant byte first. Within a field,
+	// symbolic byte N holds bits 8N to 8N+7 (see make_symbolic()).
+	std::map<std::string, uint8_t> bytes;
+	uint64_t lsb = width;
+	for (auto &field : layout) {
+		lsb -= field.bitsize;
+		if (!field.is_symbolic)
+			continue;
+
+		for (uint64_t bit = 0; bit < field.bitsize; bit++) {
+			uint64_t pos = lsb + bit;
+			size_t idx = (width - 1 - pos) / CHAR_BIT;
+			if (idx >= input.size())
+				continue; // truncated input, leave unassigned
+
+			auto &byte = bytes[field.name + ":byte" + std::to_string(bit / CHAR_BIT)];
+			if ((input.at(idx) >> (pos % CHAR_BIT)) & 1)
+				byte |= 1 << (bit % CHAR_BIT);
+		}
+	}
+
+	clover::ConcreteStore store;
+	for (auto &byte : bytes)
+		store[byte.first] = byte.second;
+
+	return store;
+}
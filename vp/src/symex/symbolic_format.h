@@ -19,6 +19,7 @@
 #define RISCV_VP_SYMBOLIC_FMT_H
 
 #include <memory>
+#include <vector>
 #include <stdint.h>
 #include <symbolic_context.h>
 #include <clover/clover.h>
@@ -32,20 +33,20 @@ private:
 	clover::Solver::Env env;
 
 	unsigned offset;
-	std::shared_ptr<clover::ConcolicValue> input;
+	clover::Ref<clover::ConcolicValue> input;
 
 	const char *input_str = nullptr;
 	ssize_t input_len;
 	bencode_t bencode;
 
-	std::shared_ptr<clover::ConcolicValue> make_symbolic(std::string name, uint64_t bitsize, size_t bytesize);
+	clover::Ref<clover::ConcolicValue> make_symbolic(std::string name, uint64_t bitsize, size_t bytesize);
 
-	std::optional<long int> get_size(bencode_t *list_elem);
-	std::optional<std::string> get_name(bencode_t *list_elem);
-	std::optional<std::shared_ptr<clover::ConcolicValue>> get_value(bencode_t *list_elem, std::string name, uint64_t bitsize);
+	static std::optional<long int> get_size(bencode_t *list_elem);
+	static std::optional<std::string> get_name(bencode_t *list_elem);
+	std::optional<clover::Ref<clover::ConcolicValue>> get_value(bencode_t *list_elem, std::string name, uint64_t bitsize);
 
-	std::shared_ptr<clover::ConcolicValue> next_field(void);
-	std::shared_ptr<clover::ConcolicValue> get_input(void);
+	clover::Ref<clover::ConcolicValue> next_field(void);
+	clover::Ref<clover::ConcolicValue> get_input(void);
 
 public:
 	SymbolicFormat(SymbolicContext &_ctx, std::string path);
@@ -55,8 +56,13 @@ public:
 	 *
 	 * Also: KLEE Array Type would be useful here ReadLSB, ReadMSB, …
 	 * See:  https://gitlab.informatik.uni-bremen.de/riscv/clover/-/issues/7 */
-	std::shared_ptr<clover::ConcolicValue> next_byte(void);
+	clover::Ref<clover::ConcolicValue> next_byte(void);
 	size_t remaning_bytes(void);
+
+	/* Map a raw input, i.e. the byte sequence returned by next_byte()
+	 * for the format at the given path, to an assignment of the
+	 * symbolic fields of this format. Constraints are not checked. */
+	static clover::ConcreteStore toStore(std::string path, const std::vector<uint8_t> &input);
 };
 
 #endif
@@ -15,6 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <vector>
+
 #include "symbolic_memory.h"
 
 SymbolicMemory::SymbolicMemory(sc_core::sc_module_name, clover::Solver &_solver, size_t _size)
@@ -22,23 +25,25 @@ SymbolicMemory::SymbolicMemory(sc_core::sc_module_name, clover::Solver &_solver,
 {
 	tsock.register_b_transport(this, &SymbolicMemory::transport);
 	tsock.register_transport_dbg(this, &SymbolicMemory::transport_dbg);
+	tsock.register_get_direct_mem_ptr(this, &SymbolicMemory::get_direct_mem_ptr);
+
+	memory.setInvalidate([this](clover::ConcolicMemory::Addr addr, size_t len) {
+		invalidate_direct_mem_ptr(addr, len);
+	});
 }
 
 void
 SymbolicMemory::load_data(const char *src, uint64_t dst_addr, size_t n)
 {
-	for (size_t i = 0; i < n; i++) {
-		auto byte = solver.BVC(std::nullopt, (uint8_t)src[i]);
-		memory.store(dst_addr + i, byte, 1);
-	}
+	memory.storeConcrete(dst_addr, (const uint8_t *)src, n);
 }
 
 void
 SymbolicMemory::load_zero(uint64_t dst_addr, size_t n)
 {
-	auto zero = solver.BVC(std::nullopt, (uint8_t)0);
-	for (size_t i = 0; i < n; i++)
-		memory.store(dst_addr + i, zero, 1);
+	std::vector<uint8_t> zero(std::min(n, clover::ConcolicMemory::PAGE_SIZE), 0);
+	for (size_t i = 0; i < n; i += zero.size())
+		memory.storeConcrete(dst_addr + i, zero.data(), std::min(n - i, zero.size()));
 }
 
 unsigned
@@ -49,7 +54,8 @@ SymbolicMemory::read_data(tlm::tlm_generic_payload &trans)
 	auto data = memory.load(trans.get_address(), size);
 	SymbolicExtension *extension = new SymbolicExtension(data);
 
-	solver.BVCToBytes(data, trans.get_data_ptr(), trans.get_data_length());
+	// The memory already holds the concrete part of each byte.
+	memory.loadConcrete(trans.get_address(), trans.get_data_ptr(), size);
 	trans.set_extension(extension);
 
 	return size;
@@ -58,7 +64,7 @@ SymbolicMemory::read_data(tlm::tlm_generic_payload &trans)
 unsigned
 SymbolicMemory::write_data(tlm::tlm_generic_payload &trans)
 {
-	std::shared_ptr<clover::ConcolicValue> value;
+	clover::Ref<clover::ConcolicValue> value;
 	auto size = trans.get_data_length();
 
 	SymbolicExtension *extension;
@@ -81,6 +87,10 @@ SymbolicMemory::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &del
 {
 	transport_dbg(trans);
 	delay += sc_core::sc_time(10, sc_core::SC_NS);
+
+	// Hint initiators that subsequent accesses may use DMI.
+	if (trans.is_response_ok())
+		trans.set_dmi_allowed(memory.isConcretePage(trans.get_address()));
 }
 
 unsigned
@@ -103,3 +113,33 @@ SymbolicMemory::transport_dbg(tlm::tlm_generic_payload &trans)
 	trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
 	return 0;
 }
+
+bool
+SymbolicMemory::get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi)
+{
+	uint64_t addr = trans.get_address();
+	if (addr >= size)
+		return false;
+
+	uint8_t *page = memory.getDirectPage(addr);
+	if (!page)
+		return false;
+
+	uint64_t start = addr & ~(uint64_t)(clover::ConcolicMemory::PAGE_SIZE - 1);
+	uint64_t end = std::min(start + clover::ConcolicMemory::PAGE_SIZE, (uint64_t)size);
+
+	dmi.set_dmi_ptr(page);
+	dmi.set_start_address(start);
+	dmi.set_end_address(end - 1);
+	dmi.allow_read_write();
+	dmi.set_read_latency(sc_core::sc_time(10, sc_core::SC_NS));
+	dmi.set_write_latency(sc_core::sc_time(10, sc_core::SC_NS));
+
+	return true;
+}
+
+void
+SymbolicMemory::invalidate_direct_mem_ptr(clover::ConcolicMemory::Addr addr, size_t len)
+{
+	tsock->invalidate_direct_mem_ptr(addr, addr + len - 1);
+}
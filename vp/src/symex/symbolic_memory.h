@@ -37,7 +37,7 @@ public:
 	size_t size;
 	clover::ConcolicMemory memory;
 
-	typedef std::shared_ptr<clover::ConcolicValue> Data;
+	typedef clover::Ref<clover::ConcolicValue> Data;
 	tlm_utils::simple_target_socket<SymbolicMemory> tsock;
 
 	SymbolicMemory(sc_core::sc_module_name, clover::Solver &_solver, size_t _size);
@@ -52,6 +52,12 @@ private:
 protected:
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
 	unsigned transport_dbg(tlm::tlm_generic_payload &trans);
+
+	/* DMI is granted for individual pages which do not hold symbolic
+	 * bytes. It is invalidated once a symbolic value is stored in the
+	 * page, such accesses must go through the transport interface. */
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload &trans, tlm::tlm_dmi &dmi);
+	void invalidate_direct_mem_ptr(clover::ConcolicMemory::Addr addr, size_t len);
 };
 
 #endif